@@ -50,6 +50,7 @@
 #include <linux/types.h>
 #include <linux/errno.h>
 #include <linux/crypto.h>
+#include <linux/spinlock.h>
 #include <linux/proc_fs.h>
 #include <linux/platform_device.h>
 #include <linux/fs.h>       /* Stuff about file systems that we need */
@@ -70,6 +71,9 @@
 
 int disable_deudma = 1;
 
+/* serialises access to the hash engine shared by sha1, md5 and the hmacs */
+DEFINE_SPINLOCK(ltq_deu_hash_lock);
+
 void chip_version(void);
 
 /*! \fn static int __init deu_init (void)
@@ -46,6 +46,7 @@
 #include <linux/types.h>
 #include <crypto/internal/hash.h>
 #include <asm/byteorder.h>
+#include <asm/unaligned.h>
 
 /* Project header */
 #if defined(CONFIG_DANUBE)
@@ -64,10 +65,13 @@
 #define MD5_HASH_WORDS      4
 #define HASH_START   IFX_HASH_CON
 
-static spinlock_t lock;
-#define CRTCL_SECT_INIT        spin_lock_init(&lock)
-#define CRTCL_SECT_START       spin_lock_irqsave(&lock, flag)
-#define CRTCL_SECT_END         spin_unlock_irqrestore(&lock, flag)
+/* blocks fed to the engine per lock acquisition */
+#define MD5_MAX_BLOCKS      16
+
+extern spinlock_t ltq_deu_hash_lock;
+#define CRTCL_SECT_INIT
+#define CRTCL_SECT_START       spin_lock_irqsave(&ltq_deu_hash_lock, flag)
+#define CRTCL_SECT_END         spin_unlock_irqrestore(&ltq_deu_hash_lock, flag)
 
 //#define CRYPTO_DEBUG
 #ifdef CRYPTO_DEBUG
@@ -98,13 +102,15 @@ static u32 endian_swap(u32 input)
     return ((ptr[3] << 24) | (ptr[2] << 16) | (ptr[1] << 8) | ptr[0]);     
 }
 
-/*! \fn static void md5_transform(u32 *hash, u32 const *in)
+/*! \fn static void md5_transform(struct md5_ctx *mctx, u32 *hash, u32 const *in, unsigned int blocks)
  *  \ingroup IFX_MD5_FUNCTIONS
  *  \brief main interface to md5 hardware   
  *  \param hash current hash value  
- *  \param in 64-byte block of input  
+ *  \param in 64-byte blocks of input, need not be aligned  
+ *  \param blocks number of blocks to process
 */                                 
-static void md5_transform(struct md5_ctx *mctx, u32 *hash, u32 const *in)
+static void md5_transform(struct md5_ctx *mctx, u32 *hash, u32 const *in,
+            unsigned int blocks)
 {
     int i;
     volatile struct deu_hash_t *hashs = (struct deu_hash_t *) HASH_START;
@@ -112,6 +118,13 @@ static void md5_transform(struct md5_ctx *mctx, u32 *hash, u32 const *in)
 
     CRTCL_SECT_START;
 
+    /* The engine is shared with sha1 and the hmac algorithms, so it has
+     * to be switched back to md5 each time we get hold of it */
+    hashs->controlr.ENDI = 0;
+    hashs->controlr.SM = 1;
+    hashs->controlr.ALGO = 1;    // 1 = md5  0 = sha1
+    hashs->controlr.INIT = 1;    // Initialize the hash operation by writing a '1' to the INIT bit.
+
     if (mctx->started) { 
         hashs->D1R = endian_swap(*((u32 *) hash + 0));
     	hashs->D2R = endian_swap(*((u32 *) hash + 1));
@@ -119,14 +132,17 @@ static void md5_transform(struct md5_ctx *mctx, u32 *hash, u32 const *in)
         hashs->D4R = endian_swap(*((u32 *) hash + 3));
     }
 
-    for (i = 0; i < 16; i++) {
-        hashs->MR = endian_swap(in[i]);
-//	printk("in[%d]: %08x\n", i, endian_swap(in[i]));
-    };
+    while (blocks--) {
+        for (i = 0; i < 16; i++) {
+            hashs->MR = endian_swap(get_unaligned(&in[i]));
+        };
 
-    //wait for processing
-    while (hashs->controlr.BSY) {
-        // this will not take long
+        //wait for processing
+        while (hashs->controlr.BSY) {
+            // this will not take long
+        }
+
+        in += 16;
     }
 
     *((u32 *) hash + 0) = endian_swap (hashs->D1R);
@@ -147,7 +163,7 @@ static void md5_transform(struct md5_ctx *mctx, u32 *hash, u32 const *in)
 static inline void md5_transform_helper(struct md5_ctx *ctx)
 {
     //le32_to_cpu_array(ctx->block, sizeof(ctx->block) / sizeof(u32));
-    md5_transform(ctx, ctx->hash, ctx->block);
+    md5_transform(ctx, ctx->hash, ctx->block, 1);
 }
 
 /*! \fn static void md5_init(struct crypto_tfm *tfm)
@@ -158,12 +174,6 @@ static inline void md5_transform_helper(struct md5_ctx *ctx)
 static int md5_init(struct shash_desc *desc)
 {
     struct md5_ctx *mctx = shash_desc_ctx(desc);
-    volatile struct deu_hash_t *hash = (struct deu_hash_t *) HASH_START;
-
-    hash->controlr.ENDI = 0;
-    hash->controlr.SM = 1;
-    hash->controlr.ALGO = 1;    // 1 = md5  0 = sha1
-    hash->controlr.INIT = 1;    // Initialize the hash operation by writing a '1' to the INIT bit.
 
     mctx->byte_count = 0;
     mctx->started = 0;
@@ -198,10 +208,12 @@ static int md5_update(struct shash_desc *desc, const u8 *data, unsigned int len)
     len -= avail;
 
     while (len >= sizeof(mctx->block)) {
-        memcpy(mctx->block, data, sizeof(mctx->block));
-        md5_transform_helper(mctx);
-        data += sizeof(mctx->block);
-        len -= sizeof(mctx->block);
+        unsigned int blocks = min_t(unsigned int, len / sizeof(mctx->block),
+                                    MD5_MAX_BLOCKS);
+
+        md5_transform(mctx, mctx->hash, (u32 const *)data, blocks);
+        data += blocks * sizeof(mctx->block);
+        len -= blocks * sizeof(mctx->block);
     }
 
     memcpy(mctx->block, data, len);
@@ -220,8 +232,6 @@ static int md5_final(struct shash_desc *desc, u8 *out)
     const unsigned int offset = mctx->byte_count & 0x3f;
     char *p = (char *)mctx->block + offset;
     int padding = 56 - (offset + 1);
-    volatile struct deu_hash_t *hashs = (struct deu_hash_t *) HASH_START;
-    unsigned long flag;
 
     *p++ = 0x80;
     if (padding < 0) {
@@ -240,16 +250,11 @@ static int md5_final(struct shash_desc *desc, u8 *out)
                       sizeof(u64)) / sizeof(u32));
 #endif
 
-    md5_transform(mctx, mctx->hash, mctx->block);                                                 
-
-    CRTCL_SECT_START;
-
-    *((u32 *) out + 0) = endian_swap (hashs->D1R);
-    *((u32 *) out + 1) = endian_swap (hashs->D2R);
-    *((u32 *) out + 2) = endian_swap (hashs->D3R);
-    *((u32 *) out + 3) = endian_swap (hashs->D4R);
+    md5_transform_helper(mctx);
 
-    CRTCL_SECT_END;
+    /* the engine may already be busy with someone else's data, the
+     * digest saved by the last transform is the one we want */
+    memcpy(out, mctx->hash, MD5_DIGEST_SIZE);
 
     // Wipe context
     memset(mctx, 0, sizeof(*mctx));
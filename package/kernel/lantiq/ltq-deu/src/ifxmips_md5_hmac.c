@@ -63,10 +63,10 @@
 #define MD5_HMAC_DBN_TEMP_SIZE  1024 // size in dword, needed for dbn workaround 
 #define HASH_START   IFX_HASH_CON
 
-static spinlock_t lock;
-#define CRTCL_SECT_INIT        spin_lock_init(&lock)
-#define CRTCL_SECT_START       spin_lock_irqsave(&lock, flag)
-#define CRTCL_SECT_END         spin_unlock_irqrestore(&lock, flag)
+extern spinlock_t ltq_deu_hash_lock;
+#define CRTCL_SECT_INIT
+#define CRTCL_SECT_START       spin_lock_irqsave(&ltq_deu_hash_lock, flag)
+#define CRTCL_SECT_END         spin_unlock_irqrestore(&ltq_deu_hash_lock, flag)
 
 //#define CRYPTO_DEBUG
 #ifdef CRYPTO_DEBUG
@@ -133,7 +133,6 @@ static void md5_hmac_transform(struct shash_desc *desc, u32 const *in)
 static int md5_hmac_setkey(struct crypto_shash *tfm, const u8 *key, unsigned int keylen) 
 {
     struct md5_hmac_ctx *mctx = crypto_shash_ctx(tfm);
-    volatile struct deu_hash_t *hash = (struct deu_hash_t *) HASH_START;
     //printk("copying keys to context with length %d\n", keylen);
 
     if (keylen > MAX_HASH_KEYLEN) {
@@ -142,7 +141,6 @@ static int md5_hmac_setkey(struct crypto_shash *tfm, const u8 *key, unsigned int
     }
  
 
-    hash->KIDX |= 0x80000000; // reset all 16 words of the key to '0'
     memcpy(&mctx->key, key, keylen);
     mctx->keylen = keylen;
 
@@ -153,7 +151,8 @@ static int md5_hmac_setkey(struct crypto_shash *tfm, const u8 *key, unsigned int
 
 /*! \fn int md5_hmac_setkey_hw(const u8 *key, unsigned int keylen)
  *  \ingroup IFX_MD5_HMAC_FUNCTIONS
- *  \brief sets md5 hmac key into the hardware registers  
+ *  \brief sets md5 hmac key into the hardware registers, must be called
+ *         with the hash engine lock held  
  *  \param key input key  
  *  \param keylen key length greater than 64 bytes IS NOT SUPPORTED  
 */  
@@ -161,13 +160,14 @@ static int md5_hmac_setkey(struct crypto_shash *tfm, const u8 *key, unsigned int
 static int md5_hmac_setkey_hw(const u8 *key, unsigned int keylen)
 {
     volatile struct deu_hash_t *hash = (struct deu_hash_t *) HASH_START;
-    unsigned long flag;
     int i, j;
     u32 *in_key = (u32 *)key;        
 
     //printk("\nsetkey keylen: %d\n key: ", keylen);
     
-    CRTCL_SECT_START;
+    hash->KIDX |= 0x80000000; // reset all 16 words of the key to '0'
+    asm("sync");
+
     j = 0;
     for (i = 0; i < keylen; i+=4)
     {
@@ -177,7 +177,6 @@ static int md5_hmac_setkey_hw(const u8 *key, unsigned int keylen)
          asm("sync");
          j++;
     }
-    CRTCL_SECT_END;
 
     return 0;
 }
@@ -194,7 +193,6 @@ static int md5_hmac_init(struct shash_desc *desc)
     
 
     mctx->dbn = 0; //dbn workaround
-    md5_hmac_setkey_hw(mctx->key, mctx->keylen);
 
     return 0;
 }
@@ -274,6 +272,10 @@ static int md5_hmac_final(struct shash_desc *desc, u8 *out)
 
     CRTCL_SECT_START;
 
+    /* The key is programmed together with the data, so that no other
+     * user of the engine can replace it in between */
+    md5_hmac_setkey_hw(mctx->key, mctx->keylen);
+
     //printk("\ndbn = %d\n", mctx->dbn); 
     hashs->DBN = mctx->dbn;
     asm("sync");
@@ -50,6 +50,7 @@
 #include <linux/types.h>
 #include <linux/scatterlist.h>
 #include <asm/byteorder.h>
+#include <asm/unaligned.h>
 
 #if defined(CONFIG_DANUBE)
 #include "ifxmips_deu_danube.h"
@@ -65,10 +66,13 @@
 #define SHA1_HMAC_BLOCK_SIZE    64
 #define HASH_START   IFX_HASH_CON
 
-static spinlock_t lock;
-#define CRTCL_SECT_INIT        spin_lock_init(&lock)
-#define CRTCL_SECT_START       spin_lock_irqsave(&lock, flag)
-#define CRTCL_SECT_END         spin_unlock_irqrestore(&lock, flag)
+/* blocks fed to the engine per lock acquisition */
+#define SHA1_MAX_BLOCKS     16
+
+extern spinlock_t ltq_deu_hash_lock;
+#define CRTCL_SECT_INIT
+#define CRTCL_SECT_START       spin_lock_irqsave(&ltq_deu_hash_lock, flag)
+#define CRTCL_SECT_END         spin_unlock_irqrestore(&ltq_deu_hash_lock, flag)
 
 //#define CRYPTO_DEBUG
 #ifdef CRYPTO_DEBUG
@@ -92,13 +96,15 @@ struct sha1_ctx {
 extern int disable_deudma;
 
 
-/*! \fn static void sha1_transform (u32 *state, const u32 *in)
+/*! \fn static void sha1_transform (struct sha1_ctx *sctx, u32 *state, const u32 *in, unsigned int blocks)
  *  \ingroup IFX_SHA1_FUNCTIONS
  *  \brief main interface to sha1 hardware   
  *  \param state current state 
- *  \param in 64-byte block of input  
+ *  \param in 64-byte blocks of input, need not be aligned  
+ *  \param blocks number of blocks to process
 */                                 
-static void sha1_transform (struct sha1_ctx *sctx, u32 *state, const u32 *in)
+static void sha1_transform (struct sha1_ctx *sctx, u32 *state, const u32 *in,
+            unsigned int blocks)
 {
     int i = 0;
     volatile struct deu_hash_t *hashs = (struct deu_hash_t *) HASH_START;
@@ -106,6 +112,11 @@ static void sha1_transform (struct sha1_ctx *sctx, u32 *state, const u32 *in)
 
     CRTCL_SECT_START;
 
+    /* The engine is shared with md5 and the hmac algorithms, so it has
+     * to be switched back to sha1 each time we get hold of it 
+    */
+    SHA_HASH_INIT;
+
     /* For context switching purposes, the previous hash output
      * is loaded back into the output register 
     */
@@ -117,13 +128,17 @@ static void sha1_transform (struct sha1_ctx *sctx, u32 *state, const u32 *in)
         hashs->D5R = *((u32 *) sctx->hash + 4);
     }
 
-    for (i = 0; i < 16; i++) {
-        hashs->MR = in[i];
-    };
+    while (blocks--) {
+        for (i = 0; i < 16; i++) {
+            hashs->MR = get_unaligned(&in[i]);
+        };
 
-    //wait for processing
-    while (hashs->controlr.BSY) {
-        // this will not take long
+        //wait for processing
+        while (hashs->controlr.BSY) {
+            // this will not take long
+        }
+
+        in += 16;
     }
    
     /* For context switching purposes, the output is saved into a 
@@ -148,8 +163,6 @@ static void sha1_transform (struct sha1_ctx *sctx, u32 *state, const u32 *in)
 static int sha1_init(struct shash_desc *desc)
 {
     struct sha1_ctx *sctx = shash_desc_ctx(desc);
-    
-    SHA_HASH_INIT;
 
     sctx->started = 0;
     sctx->count = 0;
@@ -167,16 +180,18 @@ static int sha1_update(struct shash_desc * desc, const u8 *data,
             unsigned int len)
 {
     struct sha1_ctx *sctx = shash_desc_ctx(desc);
-    unsigned int i, j;
+    unsigned int i, j, blocks;
 
     j = (sctx->count >> 3) & 0x3f;
     sctx->count += len << 3;
 
     if ((j + len) > 63) {
         memcpy (&sctx->buffer[j], data, (i = 64 - j));
-        sha1_transform (sctx, sctx->state, (const u32 *)sctx->buffer);
-        for (; i + 63 < len; i += 64) {
-            sha1_transform (sctx, sctx->state, (const u32 *)&data[i]);
+        sha1_transform (sctx, sctx->state, (const u32 *)sctx->buffer, 1);
+        while (i + 63 < len) {
+            blocks = min_t(unsigned int, (len - i) >> 6, SHA1_MAX_BLOCKS);
+            sha1_transform (sctx, sctx->state, (const u32 *)&data[i], blocks);
+            i += blocks << 6;
         }
 
         j = 0;
@@ -201,8 +216,6 @@ static int sha1_final(struct shash_desc *desc, u8 *out)
     u64 t;
     u8 bits[8] = { 0, };
     static const u8 padding[64] = { 0x80, };
-    volatile struct deu_hash_t *hashs = (struct deu_hash_t *) HASH_START;
-    unsigned long flag;
 
     t = sctx->count;
     bits[7] = 0xff & t;
@@ -229,15 +242,9 @@ static int sha1_final(struct shash_desc *desc, u8 *out)
     /* Append length */
     sha1_update (desc, bits, sizeof bits);
 
-    CRTCL_SECT_START;
-
-    *((u32 *) out + 0) = hashs->D1R;
-    *((u32 *) out + 1) = hashs->D2R;
-    *((u32 *) out + 2) = hashs->D3R;
-    *((u32 *) out + 3) = hashs->D4R;
-    *((u32 *) out + 4) = hashs->D5R;
-
-    CRTCL_SECT_END;
+    /* the engine may already be busy with someone else's data, the
+     * digest saved by the last transform is the one we want */
+    memcpy(out, sctx->hash, SHA1_DIGEST_SIZE);
 
     // Wipe context
     memset (sctx, 0, sizeof *sctx);
@@ -66,10 +66,10 @@
 
 #define SHA1_HMAC_MAX_KEYLEN 64
 
-static spinlock_t lock;
-#define CRTCL_SECT_INIT        spin_lock_init(&lock)
-#define CRTCL_SECT_START       spin_lock_irqsave(&lock, flag)
-#define CRTCL_SECT_END         spin_unlock_irqrestore(&lock, flag)
+extern spinlock_t ltq_deu_hash_lock;
+#define CRTCL_SECT_INIT
+#define CRTCL_SECT_START       spin_lock_irqsave(&ltq_deu_hash_lock, flag)
+#define CRTCL_SECT_END         spin_unlock_irqrestore(&ltq_deu_hash_lock, flag)
 
 #ifdef CRYPTO_DEBUG
 extern char debug_level;
@@ -124,7 +124,6 @@ static int sha1_hmac_transform(struct shash_desc *desc, u32 const *in)
 static int sha1_hmac_setkey(struct crypto_shash *tfm, const u8 *key, unsigned int keylen)
 {
     struct sha1_hmac_ctx *sctx = crypto_shash_ctx(tfm);
-    volatile struct deu_hash_t *hashs = (struct deu_hash_t *) HASH_START;
     
     if (keylen > SHA1_HMAC_MAX_KEYLEN) {
 	printk("Key length exceeds maximum key length\n");
@@ -133,7 +132,6 @@ static int sha1_hmac_setkey(struct crypto_shash *tfm, const u8 *key, unsigned in
 
     //printk("Setting keys of len: %d\n", keylen);
      
-    hashs->KIDX |= 0x80000000; //reset keys back to 0
     memcpy(&sctx->key, key, keylen);
     sctx->keylen = keylen;
 
@@ -142,10 +140,10 @@ static int sha1_hmac_setkey(struct crypto_shash *tfm, const u8 *key, unsigned in
 }
 
 
-/*! \fn int sha1_hmac_setkey_hw(struct crypto_tfm *tfm, const u8 *key, unsigned int keylen)
+/*! \fn int sha1_hmac_setkey_hw(const u8 *key, unsigned int keylen)
  *  \ingroup IFX_SHA1_HMAC_FUNCTIONS
- *  \brief sets sha1 hmac key  into hw registers 
- *  \param tfm linux crypto algo transform  
+ *  \brief sets sha1 hmac key  into hw registers, must be called with the
+ *         hash engine lock held 
  *  \param key input key  
  *  \param keylen key length greater than 64 bytes IS NOT SUPPORTED  
 */                                 
@@ -153,12 +151,13 @@ static int sha1_hmac_setkey_hw(const u8 *key, unsigned int keylen)
 {
     volatile struct deu_hash_t *hash = (struct deu_hash_t *) HASH_START;
     int i, j;
-    unsigned long flag;
     u32 *in_key = (u32 *)key;        
 
+    hash->KIDX |= 0x80000000; //reset keys back to 0
+    asm("sync");
+
     j = 0;
 
-    CRTCL_SECT_START;
     for (i = 0; i < keylen; i+=4)
     {
          hash->KIDX = j;
@@ -167,7 +166,6 @@ static int sha1_hmac_setkey_hw(const u8 *key, unsigned int keylen)
          j++;
     }
 
-    CRTCL_SECT_END;
     return 0;
 }
 
@@ -182,7 +180,6 @@ static int sha1_hmac_init(struct shash_desc *desc)
 
     //printk("debug ln: %d, fn: %s\n", __LINE__, __func__);
     sctx->dbn = 0; //dbn workaround
-    sha1_hmac_setkey_hw(sctx->key, sctx->keylen);
 
     return 0;
 }
@@ -266,6 +263,10 @@ static int sha1_hmac_final(struct shash_desc *desc, u8 *out)
     sha1_hmac_update (desc, bits, sizeof bits);
 
     CRTCL_SECT_START;
+
+    /* The key is programmed together with the data, so that no other
+     * user of the engine can replace it in between */
+    sha1_hmac_setkey_hw(sctx->key, sctx->keylen);
     
     hashs->DBN = sctx->dbn;
     
@@ -27,7 +27,7 @@
 /* #define _LZMA_IN_CB */
 /* Use callback for input data */
 
-/* #define _LZMA_OUT_READ */
+#define _LZMA_OUT_READ
 /* Use read function for output data */
 
 /* #define _LZMA_PROB32 */
@@ -34,18 +34,30 @@ static const char *kCantReadMessage = "Can not read from source buffer";
 static const char *kCantAllocateMessage = "Not enough buffer for decompression";
 #endif
 
-static size_t rpos=0, dpos=0;
+/* size of the chunks handed to the output callback */
+#define LZMA_OUT_CHUNK	(16 * 1024)
 
-static int MyReadFileAndCheck(unsigned char *src, void *dest, size_t size)
+/* the probability model and dictionary window are kept between calls,
+   so extracting several parts only allocates them once */
+static CProb *probs;
+static SizeT probs_size;
+static unsigned char *dict;
+static SizeT dict_size;
+
+static void *lzma_grow(void *buf, SizeT *cur, SizeT size)
 {
-  if (size == 0)
-    return 0;
-  memcpy(dest, src + rpos, size);
-  rpos += size;
-  return 1;
+  void *p;
+
+  if (size <= *cur)
+    return buf;
+
+  p = realloc(buf, size);
+  if (p)
+    *cur = size;
+  return p;
 }
 
-int lzma_inflate(unsigned char *source, int s_len, unsigned char *dest, int *d_len)
+int lzma_inflate(unsigned char *source, int s_len, lzma_out_fn out, void *priv, int *d_len)
 {
   /* We use two 32-bit integers to construct 64-bit integer for file size.
      You can remove outSizeHigh, if you don't need >= 4GB supporting,
@@ -53,21 +65,20 @@ int lzma_inflate(unsigned char *source, int s_len, unsigned char *dest, int *d_l
   UInt32 outSize = 0;
   UInt32 outSizeHigh = 0;
   SizeT outSizeFull;
-  unsigned char *outStream;
-  
+  unsigned char outStream[LZMA_OUT_CHUNK];
+
   int waitEOS = 1; 
   /* waitEOS = 1, if there is no uncompressed size in headers, 
    so decoder will wait EOS (End of Stream Marker) in compressed stream */
 
   SizeT compressedSize;
   unsigned char *inStream;
+  size_t rpos = 0;
 
   CLzmaDecoderState state;  /* it's about 24-80 bytes structure, if int is 32-bit */
-  unsigned char properties[LZMA_PROPERTIES_SIZE];
+  void *p;
 
-  int res;
-
-  rpos=0; dpos=0;
+  int res = LZMA_RESULT_OK;
 
   if (sizeof(UInt32) < 4)
   {
@@ -77,41 +88,31 @@ int lzma_inflate(unsigned char *source, int s_len, unsigned char *dest, int *d_l
     return LZMA_RESULT_DATA_ERROR;
   }
 
+  if (s_len < LZMA_PROPERTIES_SIZE + 8)
   {
-    long length=s_len;
-    if ((long)(SizeT)length != length)
-    {
 #if defined(DEBUG_ENABLE_BOOTSTRAP_PRINTF) || !defined(CFG_BOOTSTRAP_CODE)
-      printf("Too big compressed stream\n");
+    printf("%s\n", kCantReadMessage);
 #endif
-      return LZMA_RESULT_DATA_ERROR;
-    }
-    compressedSize = (SizeT)(length - (LZMA_PROPERTIES_SIZE + 8));
+    return LZMA_RESULT_DATA_ERROR;
   }
+  compressedSize = (SizeT)(s_len - (LZMA_PROPERTIES_SIZE + 8));
 
-  /* Read LZMA properties for compressed stream */
-
-  if (!MyReadFileAndCheck(source, properties, sizeof(properties)))
+  /* Decode LZMA properties */
+  if (LzmaDecodeProperties(&state.Properties, source, LZMA_PROPERTIES_SIZE) != LZMA_RESULT_OK)
   {
 #if defined(DEBUG_ENABLE_BOOTSTRAP_PRINTF) || !defined(CFG_BOOTSTRAP_CODE)
-    printf("%s\n", kCantReadMessage);
+    printf("Incorrect stream properties");
 #endif
     return LZMA_RESULT_DATA_ERROR;
   }
+  rpos += LZMA_PROPERTIES_SIZE;
 
   /* Read uncompressed size */
   {
     int i;
     for (i = 0; i < 8; i++)
     {
-      unsigned char b;
-      if (!MyReadFileAndCheck(source, &b, 1))
-      {
-#if defined(DEBUG_ENABLE_BOOTSTRAP_PRINTF) || !defined(CFG_BOOTSTRAP_CODE)
-        printf("%s\n", kCantReadMessage);
-#endif
-        return LZMA_RESULT_DATA_ERROR;
-      }
+      unsigned char b = source[rpos++];
       if (b != 0xFF)
         waitEOS = 0;
       if (i < 4)
@@ -138,69 +139,63 @@ int lzma_inflate(unsigned char *source, int s_len, unsigned char *dest, int *d_l
       return LZMA_RESULT_DATA_ERROR;
     }
   }
+  inStream = source + rpos;
 
-  /* Decode LZMA properties and allocate memory */
-  if (LzmaDecodeProperties(&state.Properties, properties, LZMA_PROPERTIES_SIZE) != LZMA_RESULT_OK)
-  {
-#if defined(DEBUG_ENABLE_BOOTSTRAP_PRINTF) || !defined(CFG_BOOTSTRAP_CODE)
-    printf("Incorrect stream properties");
-#endif
-    return LZMA_RESULT_DATA_ERROR;
-  }
-  state.Probs = (CProb *)malloc(LzmaGetNumProbs(&state.Properties) * sizeof(CProb));
-
-  if (outSizeFull == 0)
-    outStream = 0;
-  else
-  {
-    if (outSizeFull > *d_len)
-      outStream = 0;
-    else
-      outStream = dest;
-  }
+  /* No match can reach back further than the start of the output, so
+     the window never needs to be larger than the output itself */
+  if (outSizeFull && state.Properties.DictionarySize > outSizeFull)
+    state.Properties.DictionarySize = (UInt32)outSizeFull;
 
-  if (compressedSize == 0)
-    inStream = 0;
-  else
+  p = lzma_grow(probs, &probs_size,
+    LzmaGetNumProbs(&state.Properties) * sizeof(CProb));
+  if (p)
   {
-    if ((compressedSize+rpos) > s_len )
-      inStream = 0;
-    else
-      inStream = source + rpos;
+    probs = p;
+    p = lzma_grow(dict, &dict_size, state.Properties.DictionarySize);
+    if (p)
+      dict = p;
   }
-
-  if (state.Probs == 0 
-    || (outStream == 0 && outSizeFull != 0)
-    || (inStream == 0 && compressedSize != 0)
-    )
+  if (!p)
   {
-    free(state.Probs);
 #if defined(DEBUG_ENABLE_BOOTSTRAP_PRINTF) || !defined(CFG_BOOTSTRAP_CODE)
     printf("%s\n", kCantAllocateMessage);
 #endif
     return LZMA_RESULT_DATA_ERROR;
   }
+  state.Probs = probs;
+  state.Dictionary = dict;
+  LzmaDecoderInit(&state);
 
-  /* Decompress */
+  /* Decompress, handing out one chunk at a time */
+  *d_len = 0;
+  while (outSizeFull > 0)
   {
     SizeT inProcessed;
     SizeT outProcessed;
+    SizeT chunk = outSizeFull < sizeof(outStream) ? outSizeFull : sizeof(outStream);
+
     res = LzmaDecode(&state,
       inStream, compressedSize, &inProcessed,
-      outStream, outSizeFull, &outProcessed);
-    if (res != 0)
+      outStream, chunk, &outProcessed);
+    if (res != 0 || outProcessed == 0)
     {
 #if defined(DEBUG_ENABLE_BOOTSTRAP_PRINTF) || !defined(CFG_BOOTSTRAP_CODE)
       printf("\nDecoding error = %d\n", res);
 #endif
       res = 1;
+      break;
     }
-    else
+    inStream += inProcessed;
+    compressedSize -= inProcessed;
+    outSizeFull -= outProcessed;
+
+    if (out(priv, outStream, outProcessed))
     {
-      *d_len = outProcessed;
+      res = 1;
+      break;
     }
+    *d_len += outProcessed;
   }
 
-  free(state.Probs);
   return res;
 }
@@ -31,6 +31,9 @@
 #define LZMA_RESULT_DATA_ERROR 1
 #endif
 
-extern int lzma_inflate(unsigned char *source, int s_len, unsigned char *dest, int *d_len);
+/* called for every decompressed chunk, returns non-zero to abort */
+typedef int (*lzma_out_fn)(void *priv, unsigned char *buf, int len);
+
+extern int lzma_inflate(unsigned char *source, int s_len, lzma_out_fn out, void *priv, int *d_len);
 
 #endif /*__LZMA_WRAPPER_H__*/
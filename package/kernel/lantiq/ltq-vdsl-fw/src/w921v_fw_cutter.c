@@ -55,6 +55,13 @@ const char* part_type(unsigned int id)
 	return "/tmp/unknown.lzma";
 }
 
+static int write_part(void *priv, unsigned char *buf, int len)
+{
+	int fd = *(int *)priv;
+
+	return write(fd, buf, len) != len;
+}
+
 int main(int argc, char **argv)
 {
 	struct stat s;
@@ -63,7 +70,6 @@ int main(int argc, char **argv)
 	int buflen;
 	int fd;
 	int i;
-	int err;
 	int start = 0, end = 0;
 
 	printf("Arcadyan Firmware cutter v0.1\n");
@@ -82,12 +88,13 @@ int main(int argc, char **argv)
 		return -1;
 	}
 
-	buf_orig = malloc(s.st_size);
+	/* descramble in place, the image is never held in memory twice */
 	buf = malloc(s.st_size);
-	if (!buf_orig || !buf) {
+	if (!buf) {
 		printf("Failed to alloc %d bytes\n", s.st_size);
 		return -1;
 	}
+	buf_orig = (unsigned char *)buf;
 
 	fd = open(FW_NAME, O_RDONLY);
 	if (fd < 0) {
@@ -95,17 +102,14 @@ int main(int argc, char **argv)
 		return -1;
 	}
 
-
-	buflen = read(fd, buf_orig, s.st_size);
+	/* <magic> */
+	buflen = pread(fd, buf_orig, s.st_size - 1, 1);
 	close(fd);
-	if (buflen != s.st_size) {
-		printf("Loaded %d instead of %d bytes inside %s\n", buflen, s.st_size, FW_NAME);
+	if (buflen != s.st_size - 1) {
+		printf("Loaded %d instead of %d bytes inside %s\n", buflen + 1, s.st_size, FW_NAME);
 		return -1;
 	}
 
-	/* <magic> */
-	buf_orig++;
-	buflen -= 1;
 	for (i = 0; i < MAGIC_SZ; i++) {
 		if ((i % 16) < 3)
 			buf_orig[i] = buf_orig[i + 16] ^ MAGIC;
@@ -114,7 +118,6 @@ int main(int argc, char **argv)
 	}
 	buflen -= 3;
 	memmove(&buf_orig[MAGIC_SZ], &buf_orig[MAGIC_SZ + 3], buflen - MAGIC_SZ);
-	memcpy(buf, buf_orig, s.st_size);
 
 	/* </magic> */
 	do {
@@ -124,34 +127,27 @@ int main(int argc, char **argv)
 				start * sizeof(unsigned int),
 				(end - start) * sizeof(unsigned int));
 			if (buf[start] == MAGIC_LZMA) {
-				int dest_len = 1024 * 1024;
+				int dest_len;
 				int len = buf[end - 3];
 				unsigned int id = buf[end - 6];
 				const char *type = part_type(id);
-				unsigned char *dest;
 
-				dest = malloc(dest_len);
-				if (!dest) {
-					printf("Failed to alloc dest buffer\n");
-					return -1;
+				fd = creat(type, S_IRUSR | S_IWUSR);
+				if (fd == -1) {
+					printf("\tFailed to open %s\n", type);
+					start = end;
+					continue;
 				}
 
-				if (lzma_inflate((unsigned char*)&buf[start], len, dest, &dest_len)) {
+				if (lzma_inflate((unsigned char*)&buf[start], len, write_part, &fd, &dest_len)) {
 					printf("Failed to decompress data\n");
+					close(fd);
+					unlink(type);
 					return -1;
 				}
 
-				fd = creat(type, S_IRUSR | S_IWUSR);
-				if (fd != -1) {
-					if (write(fd, dest, dest_len) != dest_len)
-						printf("\tFailed to write %d bytes\n", dest_len);
-					else
-						printf("\tWrote %d bytes to %s\n", dest_len, type);
-					close(fd);
-				} else {
-					printf("\tFailed to open %s\n", type);
-				}
-				free(dest);
+				close(fd);
+				printf("\tWrote %d bytes to %s\n", dest_len, type);
 			} else {
 				printf("\tThis is not lzma\n");
 			}
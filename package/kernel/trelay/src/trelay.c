@@ -19,6 +19,9 @@
 #include <linux/netdevice.h>
 #include <linux/rtnetlink.h>
 #include <linux/debugfs.h>
+#include <linux/interrupt.h>
+#include <linux/u64_stats_sync.h>
+#include <net/sch_generic.h>
 
 #define trelay_log(loglevel, tr, fmt, ...) \
 	printk(loglevel "trelay: %s <-> %s: " fmt "\n", \
@@ -27,42 +30,256 @@
 static LIST_HEAD(trelay_devs);
 static struct dentry *debugfs_dir;
 
+struct trelay_stats {
+	u64 packets;
+	u64 bytes;
+	u64 dropped;
+	struct u64_stats_sync syncp;
+};
+
+/*
+ * Frames taking the fast path are collected per CPU while the receive
+ * softirq runs and sent in one go from a tasklet afterwards, which lets
+ * the egress driver delay its doorbell with xmit_more. Each relay has its
+ * own queues, so removing it only has to wait for its own frames.
+ */
+struct trelay_xmit {
+	struct sk_buff_head queue;
+	struct tasklet_struct tasklet;
+};
+
+/* one relay direction, used as rx_handler_data of the ingress device */
+struct trelay_port {
+	struct net_device *dev;		/* egress device */
+	struct trelay_stats __percpu *stats;
+	struct trelay_xmit __percpu *xmit;
+	bool *fastpath;
+};
+
 struct trelay {
 	struct list_head list;
 	struct net_device *dev1, *dev2;
+	struct trelay_port port1, port2;	/* dev1 -> dev2, dev2 -> dev1 */
+	struct trelay_xmit __percpu *xmit;
 	struct dentry *debugfs;
 	int to_remove;
+	bool fastpath;
 	char name[];
 };
 
+struct trelay_xmit_cb {
+	struct trelay_port *port;
+};
+
+#define TRELAY_XMIT_CB(skb) ((struct trelay_xmit_cb *)(skb)->cb)
+
+static void trelay_count(struct trelay_port *port, unsigned int len, bool sent)
+{
+	struct trelay_stats *stats = this_cpu_ptr(port->stats);
+
+	u64_stats_update_begin(&stats->syncp);
+	if (sent) {
+		stats->packets++;
+		stats->bytes += len;
+	} else {
+		stats->dropped++;
+	}
+	u64_stats_update_end(&stats->syncp);
+}
+
+/*
+ * The qdisc layer can only be skipped if the egress device has no queue
+ * to speak of and the frame needs no software fixups before transmit.
+ */
+static bool trelay_can_bypass(struct net_device *dev, struct sk_buff *skb)
+{
+	struct netdev_queue *txq;
+
+	if (dev->real_num_tx_queues != 1 || !netif_running(dev))
+		return false;
+
+	if (skb_is_gso(skb) || skb_vlan_tag_present(skb) ||
+	    skb->ip_summed == CHECKSUM_PARTIAL)
+		return false;
+
+#ifdef CONFIG_NET_CLS_ACT
+	if (rcu_access_pointer(dev->miniq_egress))
+		return false;
+#endif
+
+	txq = netdev_get_tx_queue(dev, 0);
+	return !rcu_dereference_bh(txq->qdisc)->enqueue;
+}
+
+/*
+ * Take the next frame off the queue that survives the same fixups as
+ * dev_queue_xmit() applies for what the device cannot offload, GSO frames
+ * never get here
+ */
+static struct sk_buff *trelay_xmit_next(struct sk_buff_head *queue)
+{
+	struct trelay_port *port;
+	struct sk_buff *skb;
+	unsigned int len;
+	bool again;
+
+	while ((skb = __skb_dequeue(queue)) != NULL) {
+		port = TRELAY_XMIT_CB(skb)->port;
+		len = skb->len;
+		again = false;
+
+		skb = validate_xmit_skb_list(skb, skb->dev, &again);
+		if (skb)
+			return skb;
+
+		if (!again)
+			trelay_count(port, len, false);
+	}
+
+	return NULL;
+}
+
+static void trelay_xmit_direct(struct sk_buff *skb, bool more)
+{
+	struct trelay_port *port = TRELAY_XMIT_CB(skb)->port;
+	struct net_device *dev = skb->dev;
+	struct netdev_queue *txq;
+	netdev_tx_t ret = NETDEV_TX_BUSY;
+	unsigned int len = skb->len;
+
+	skb_set_queue_mapping(skb, 0);
+	txq = netdev_get_tx_queue(dev, 0);
+
+	HARD_TX_LOCK(dev, txq, smp_processor_id());
+	if (!netif_xmit_frozen_or_drv_stopped(txq)) {
+		if (dev_nit_active(dev))
+			dev_queue_xmit_nit(skb, dev);
+
+		ret = netdev_start_xmit(skb, dev, txq, more);
+	}
+	HARD_TX_UNLOCK(dev, txq);
+
+	if (!dev_xmit_complete(ret)) {
+		kfree_skb(skb);
+		trelay_count(port, len, false);
+		return;
+	}
+
+	trelay_count(port, len, true);
+}
+
+static void trelay_xmit_flush(unsigned long data)
+{
+	struct trelay_xmit *xmit = (struct trelay_xmit *)data;
+	struct sk_buff_head *queue = &xmit->queue;
+	struct sk_buff *skb, *next;
+
+	/* the following frame is validated first, so that xmit_more is only
+	 * set when it is really going to be handed to the same device */
+	skb = trelay_xmit_next(queue);
+	while (skb) {
+		next = trelay_xmit_next(queue);
+		trelay_xmit_direct(skb, next && next->dev == skb->dev);
+		skb = next;
+	}
+}
+
 rx_handler_result_t trelay_handle_frame(struct sk_buff **pskb)
 {
+	struct trelay_port *port;
 	struct net_device *dev;
 	struct sk_buff *skb = *pskb;
+	unsigned int len;
 
-	dev = rcu_dereference(skb->dev->rx_handler_data);
-	if (!dev)
+	port = rcu_dereference(skb->dev->rx_handler_data);
+	if (!port)
 		return RX_HANDLER_PASS;
 
 	if (skb->protocol == htons(ETH_P_PAE))
 		return RX_HANDLER_PASS;
 
+	dev = port->dev;
 	skb_push(skb, ETH_HLEN);
 	skb->dev = dev;
 	skb_forward_csum(skb);
-	dev_queue_xmit(skb);
+
+	if (READ_ONCE(*port->fastpath) && trelay_can_bypass(dev, skb)) {
+		struct trelay_xmit *xmit = this_cpu_ptr(port->xmit);
+
+		TRELAY_XMIT_CB(skb)->port = port;
+		__skb_queue_tail(&xmit->queue, skb);
+		tasklet_schedule(&xmit->tasklet);
+		return RX_HANDLER_CONSUMED;
+	}
+
+	len = skb->len;
+	trelay_count(port, len, !net_xmit_eval(dev_queue_xmit(skb)));
 
 	return RX_HANDLER_CONSUMED;
 }
 
+static void trelay_stats_fold(struct trelay_port *port, struct trelay_stats *sum)
+{
+	int cpu;
+
+	memset(sum, 0, sizeof(*sum));
+	for_each_possible_cpu(cpu) {
+		struct trelay_stats *stats = per_cpu_ptr(port->stats, cpu);
+		u64 packets, bytes, dropped;
+		unsigned int start;
+
+		do {
+			start = u64_stats_fetch_begin_irq(&stats->syncp);
+			packets = stats->packets;
+			bytes = stats->bytes;
+			dropped = stats->dropped;
+		} while (u64_stats_fetch_retry_irq(&stats->syncp, start));
+
+		sum->packets += packets;
+		sum->bytes += bytes;
+		sum->dropped += dropped;
+	}
+}
+
 static int trelay_open(struct inode *inode, struct file *file)
 {
 	file->private_data = inode->i_private;
 	return 0;
 }
 
+static ssize_t trelay_stats_read(struct file *file, char __user *ubuf,
+				 size_t count, loff_t *ppos)
+{
+	struct trelay *tr = file->private_data;
+	struct trelay_stats s1, s2;
+	char buf[256];
+	int len;
+
+	trelay_stats_fold(&tr->port1, &s1);
+	trelay_stats_fold(&tr->port2, &s2);
+
+	len = scnprintf(buf, sizeof(buf),
+			"%s -> %s: packets %llu bytes %llu dropped %llu\n"
+			"%s -> %s: packets %llu bytes %llu dropped %llu\n",
+			tr->dev1->name, tr->dev2->name,
+			s1.packets, s1.bytes, s1.dropped,
+			tr->dev2->name, tr->dev1->name,
+			s2.packets, s2.bytes, s2.dropped);
+
+	return simple_read_from_buffer(ubuf, count, ppos, buf, len);
+}
+
+static const struct file_operations fops_stats = {
+	.owner = THIS_MODULE,
+	.open = trelay_open,
+	.read = trelay_stats_read,
+	.llseek = default_llseek,
+};
+
 static int trelay_do_remove(struct trelay *tr)
 {
+	int cpu;
+
 	list_del(&tr->list);
 
 	/* First and before all, ensure that the debugfs file is removed
@@ -75,8 +292,20 @@ static int trelay_do_remove(struct trelay *tr)
 	netdev_rx_handler_unregister(tr->dev1);
 	netdev_rx_handler_unregister(tr->dev2);
 
+	/* No new frames can be queued now, wait for a pending flush to send
+	 * them and drop whatever is left */
+	for_each_possible_cpu(cpu) {
+		struct trelay_xmit *xmit = per_cpu_ptr(tr->xmit, cpu);
+
+		tasklet_kill(&xmit->tasklet);
+		__skb_queue_purge(&xmit->queue);
+	}
+
 	trelay_log(KERN_INFO, tr, "stopped");
 
+	free_percpu(tr->xmit);
+	free_percpu(tr->port1.stats);
+	free_percpu(tr->port2.stats);
 	kfree(tr);
 
 	return 0;
@@ -150,12 +379,28 @@ static int trelay_do_add(char *name, char *devn1, char *devn2)
 {
 	struct net_device *dev1, *dev2;
 	struct trelay *tr, *tr1;
-	int ret;
+	int ret, cpu;
 
 	tr = kzalloc(sizeof(*tr) + strlen(name) + 1, GFP_KERNEL);
 	if (!tr)
 		return -ENOMEM;
 
+	tr->port1.stats = netdev_alloc_pcpu_stats(struct trelay_stats);
+	tr->port2.stats = netdev_alloc_pcpu_stats(struct trelay_stats);
+	tr->xmit = alloc_percpu(struct trelay_xmit);
+	if (!tr->port1.stats || !tr->port2.stats || !tr->xmit) {
+		ret = -ENOMEM;
+		goto free;
+	}
+
+	for_each_possible_cpu(cpu) {
+		struct trelay_xmit *xmit = per_cpu_ptr(tr->xmit, cpu);
+
+		__skb_queue_head_init(&xmit->queue);
+		tasklet_init(&xmit->tasklet, trelay_xmit_flush,
+			     (unsigned long)xmit);
+	}
+
 	rtnl_lock();
 	rcu_read_lock();
 
@@ -171,11 +416,18 @@ static int trelay_do_add(char *name, char *devn1, char *devn2)
 	if (!dev1 || !dev2)
 		goto out;
 
-	ret = netdev_rx_handler_register(dev1, trelay_handle_frame, dev2);
+	tr->port1.dev = dev2;
+	tr->port1.xmit = tr->xmit;
+	tr->port1.fastpath = &tr->fastpath;
+	tr->port2.dev = dev1;
+	tr->port2.xmit = tr->xmit;
+	tr->port2.fastpath = &tr->fastpath;
+
+	ret = netdev_rx_handler_register(dev1, trelay_handle_frame, &tr->port1);
 	if (ret < 0)
 		goto out;
 
-	ret = netdev_rx_handler_register(dev2, trelay_handle_frame, dev1);
+	ret = netdev_rx_handler_register(dev2, trelay_handle_frame, &tr->port2);
 	if (ret < 0) {
 		netdev_rx_handler_unregister(dev1);
 		goto out;
@@ -193,13 +445,21 @@ static int trelay_do_add(char *name, char *devn1, char *devn2)
 
 	tr->debugfs = debugfs_create_dir(name, debugfs_dir);
 	debugfs_create_file("remove", S_IWUSR, tr->debugfs, tr, &fops_remove);
+	debugfs_create_file("stats", S_IRUSR, tr->debugfs, tr, &fops_stats);
+	debugfs_create_bool("fastpath", S_IRUSR | S_IWUSR, tr->debugfs,
+			    &tr->fastpath);
 	ret = 0;
 
 out:
 	rcu_read_unlock();
 	rtnl_unlock();
-	if (ret < 0)
+free:
+	if (ret < 0) {
+		free_percpu(tr->xmit);
+		free_percpu(tr->port1.stats);
+		free_percpu(tr->port2.stats);
 		kfree(tr);
+	}
 
 	return ret;
 }
@@ -87,10 +87,31 @@ static const unsigned short maplen[] = {
 	[EUC_TW]    = 4+ 2* 2*94*94,
 };
 
+#define NUM_CHARMAPS (sizeof(charmaps) / sizeof(charmaps[0]))
+
+/* UCS2_8BIT high half expanded to UTF-8, len 0 marks an unmapped byte */
+struct sb_utf8 {
+	unsigned char len;
+	unsigned char b[3];
+};
+
+static struct sb_utf8 *sb_utf8_tab[NUM_CHARMAPS];
+
+/* most recently opened descriptors, per thread */
+#define OPEN_CACHE_SIZE 4
+#define OPEN_CACHE_NAME 16
+
+static __thread struct {
+	char to[OPEN_CACHE_NAME];
+	char from[OPEN_CACHE_NAME];
+	iconv_t cd;
+} open_cache[OPEN_CACHE_SIZE];
+static __thread unsigned open_cache_next;
+
 static int find_charmap(const char *name)
 {
 	int i;
-	for (i = 0; i < (sizeof(charmaps) / sizeof(charmaps[0])); i++)
+	for (i = 0; i < NUM_CHARMAPS; i++)
 		if (!strcasecmp(charmaps[i].name, name))
 			return i;
 	return -1;
@@ -103,7 +124,36 @@ static int find_charset(const char *name)
 	return *s;
 }
 
-iconv_t iconv_open(const char *to, const char *from)
+static inline int utf8enc_wchar(char *outb, wchar_t c);
+
+static inline wchar_t get_16(const unsigned char *s, int endian);
+
+static void build_sb_utf8(int m)
+{
+	const unsigned char *map = charmaps[m].map;
+	struct sb_utf8 *tab;
+	wchar_t c;
+	int i;
+
+	if (map[0] != UCS2_8BIT || sb_utf8_tab[m])
+		return;
+
+	tab = calloc(128, sizeof(*tab));
+	if (!tab)
+		return;
+
+	for (i = 0; i < 128; i++) {
+		c = get_16(map + 4 + 2*i, 0);
+		if (c != 0xffff)
+			tab[i].len = utf8enc_wchar((char *)tab[i].b, c);
+	}
+
+	/* another thread may have raced us to it */
+	if (!__sync_bool_compare_and_swap(&sb_utf8_tab[m], NULL, tab))
+		free(tab);
+}
+
+static iconv_t do_iconv_open(const char *to, const char *from)
 {
 	unsigned f, t;
 	int m;
@@ -114,12 +164,39 @@ iconv_t iconv_open(const char *to, const char *from)
 	if ((f = find_charset(from)) < 255)
 		return 0 | (t<<1) | (f<<8);
 
-	if ((m = find_charmap(from)) > -1)
+	if ((m = find_charmap(from)) > -1) {
+		if (t == UTF_8)
+			build_sb_utf8(m);
 		return 1 | (t<<1) | (m<<8);
+	}
 
 	return -1;
 }
 
+iconv_t iconv_open(const char *to, const char *from)
+{
+	iconv_t cd;
+	int i;
+
+	for (i = 0; i < OPEN_CACHE_SIZE; i++)
+		if (open_cache[i].to[0] &&
+		    !strcasecmp(open_cache[i].to, to) &&
+		    !strcasecmp(open_cache[i].from, from))
+			return open_cache[i].cd;
+
+	cd = do_iconv_open(to, from);
+
+	if (cd != -1 &&
+	    strlen(to) < OPEN_CACHE_NAME && strlen(from) < OPEN_CACHE_NAME) {
+		i = open_cache_next++ % OPEN_CACHE_SIZE;
+		strcpy(open_cache[i].to, to);
+		strcpy(open_cache[i].from, from);
+		open_cache[i].cd = cd;
+	}
+
+	return cd;
+}
+
 int iconv_close(iconv_t cd)
 {
 	return 0;
@@ -168,6 +245,25 @@ static inline int utf8enc_wchar(char *outb, wchar_t c)
 	}
 }
 
+/* copy the leading run of 7-bit bytes, at most n, a word at a time */
+static size_t ascii_run(const char *s, char *d, size_t n)
+{
+	const size_t hi = (size_t)-1 / 0xff * 0x80;
+	size_t i = 0, w;
+
+	for (; i + sizeof(w) <= n; i += sizeof(w)) {
+		memcpy(&w, s + i, sizeof(w));
+		if (w & hi)
+			break;
+		memcpy(d + i, &w, sizeof(w));
+	}
+
+	for (; i < n && !(s[i] & 0x80); i++)
+		d[i] = s[i];
+
+	return i;
+}
+
 static inline int utf8seq_is_overlong(char *s, int n)
 {
 	switch (n)
@@ -275,22 +371,36 @@ size_t iconv(iconv_t cd, char **in, size_t *inb, char **out, size_t *outb)
 	unsigned char to = (cd>>1)&127;
 	unsigned char from = 255;
 	const unsigned char *map = 0;
+	const struct sb_utf8 *sb = 0;
 	char tmp[MB_LEN_MAX];
 	wchar_t c, d;
 	size_t k, l;
 	int err;
+	/* 7-bit input passes through unchanged to these */
+	int ascii_out = to == UTF_8 || to == US_ASCII ||
+	                to == LATIN_1 || to == LATIN_9;
 
 	if (!in || !*in || !*inb) return 0;
 
-	if (cd & 1)
+	if (cd & 1) {
 		map = charmaps[cd>>8].map;
-	else
+		if (to == UTF_8)
+			sb = sb_utf8_tab[cd>>8];
+	} else
 		from = cd>>8;
 
 	for (; *inb; *in+=l, *inb-=l) {
 		c = *(unsigned char *)*in;
 		l = 1;
-		if (from >= UTF_8 && c < 0x80) goto charok;
+		if (from >= UTF_8 && c < 0x80) {
+			if (ascii_out && *outb) {
+				l = ascii_run(*in, *out, *inb < *outb ? *inb : *outb);
+				*out += l;
+				*outb -= l;
+				continue;
+			}
+			goto charok;
+		}
 		switch (from) {
 		case WCHAR_T:
 			l = sizeof(wchar_t);
@@ -352,6 +462,15 @@ size_t iconv(iconv_t cd, char **in, size_t *inb, char **out, size_t *outb)
 			if (c < 0x80) break;
 			switch (map[0]) {
 			case UCS2_8BIT:
+				if (sb) {
+					k = sb[c - 0x80].len;
+					if (!k) goto ilseq;
+					if (*outb < k) goto toobig;
+					memcpy(*out, sb[c - 0x80].b, k);
+					*out += k;
+					*outb -= k;
+					continue;
+				}
 				c -= 0x80;
 				break;
 			case EUC:
@@ -42,6 +42,7 @@ enum {
 	CMD_HELP,
 	CMD_SHOW,
 	CMD_PORTMAP,
+	CMD_MONITOR,
 };
 
 static void
@@ -102,43 +103,47 @@ speed_str(int speed)
 }
 
 static void
-print_attr_val(const struct switch_attr *attr, const struct switch_val *val)
+print_link(FILE *f, int port, const struct switch_port_link *link)
+{
+	if (link->link)
+		fprintf(f, "port:%d link:up speed:%s %s-duplex %s%s%s%s%s",
+			port,
+			speed_str(link->speed),
+			link->duplex ? "full" : "half",
+			link->tx_flow ? "txflow " : "",
+			link->rx_flow ? "rxflow " : "",
+			link->eee & SWLIB_LINK_FLAG_EEE_100BASET ? "eee100 " : "",
+			link->eee & SWLIB_LINK_FLAG_EEE_1000BASET ? "eee1000 " : "",
+			link->aneg ? "auto" : "");
+	else
+		fprintf(f, "port:%d link:down", port);
+}
+
+static void
+print_attr_val(FILE *f, const struct switch_attr *attr, const struct switch_val *val)
 {
-	struct switch_port_link *link;
 	int i;
 
 	switch (attr->type) {
 	case SWITCH_TYPE_INT:
-		printf("%d", val->value.i);
+		fprintf(f, "%d", val->value.i);
 		break;
 	case SWITCH_TYPE_STRING:
-		printf("%s", val->value.s);
+		fprintf(f, "%s", val->value.s);
 		break;
 	case SWITCH_TYPE_PORTS:
 		for(i = 0; i < val->len; i++) {
-			printf("%d%s ",
+			fprintf(f, "%d%s ",
 				val->value.ports[i].id,
 				(val->value.ports[i].flags &
 				 SWLIB_PORT_FLAG_TAGGED) ? "t" : "");
 		}
 		break;
 	case SWITCH_TYPE_LINK:
-		link = val->value.link;
-		if (link->link)
-			printf("port:%d link:up speed:%s %s-duplex %s%s%s%s%s",
-				val->port_vlan,
-				speed_str(link->speed),
-				link->duplex ? "full" : "half",
-				link->tx_flow ? "txflow " : "",
-				link->rx_flow ? "rxflow " : "",
-				link->eee & SWLIB_LINK_FLAG_EEE_100BASET ? "eee100 " : "",
-				link->eee & SWLIB_LINK_FLAG_EEE_1000BASET ? "eee1000 " : "",
-				link->aneg ? "auto" : "");
-		else
-			printf("port:%d link:down", val->port_vlan);
+		print_link(f, val->port_vlan, val->value.link);
 		break;
 	default:
-		printf("?unknown-type?");
+		fprintf(f, "?unknown-type?");
 	}
 }
 
@@ -151,7 +156,7 @@ show_attrs(struct switch_dev *dev, struct switch_attr *attr, struct switch_val *
 			if (swlib_get_attr(dev, attr, val) < 0)
 				printf("???");
 			else
-				print_attr_val(attr, val);
+				print_attr_val(stdout, attr, val);
 			putchar('\n');
 		}
 		attr = attr->next;
@@ -198,11 +203,122 @@ show_vlan(struct switch_dev *dev, int vlan, bool all)
 	show_attrs(dev, dev->vlan_ops, &val);
 }
 
+static int
+print_event(const struct switch_event *ev, void *arg)
+{
+	int *port = arg;
+
+	if (*port >= 0 && ev->port != *port)
+		return 0;
+
+	printf("%s: ", ev->dev_name);
+	switch (ev->type) {
+	case SWLIB_EVENT_LINK:
+		print_link(stdout, ev->port, &ev->link);
+		break;
+	case SWLIB_EVENT_STATS:
+		printf("port:%d tx_bytes:+%llu rx_bytes:+%llu",
+			ev->port, ev->tx_bytes, ev->rx_bytes);
+		break;
+	}
+	putchar('\n');
+	fflush(stdout);
+
+	return 0;
+}
+
+struct show_state {
+	int atype;
+	int port_vlan;
+	int count;
+	FILE *out;
+	char *buf;
+	size_t len;
+	bool show;
+};
+
+static void
+show_section_end(struct show_state *st)
+{
+	if (st->out && st->out != stdout) {
+		fclose(st->out);
+		if (st->show)
+			fputs(st->buf, stdout);
+		free(st->buf);
+	}
+	st->out = NULL;
+}
+
+static void
+show_value(struct switch_attr *attr, struct switch_val *val, void *arg)
+{
+	struct show_state *st = arg;
+
+	if (!st->out || attr->atype != st->atype ||
+	    val->port_vlan != st->port_vlan) {
+		show_section_end(st);
+		st->atype = attr->atype;
+		st->port_vlan = val->port_vlan;
+		st->show = true;
+		st->out = stdout;
+
+		switch (attr->atype) {
+		case SWLIB_ATTR_GROUP_GLOBAL:
+			printf("Global attributes:\n");
+			break;
+		case SWLIB_ATTR_GROUP_PORT:
+			printf("Port %d:\n", val->port_vlan);
+			break;
+		case SWLIB_ATTR_GROUP_VLAN:
+			/* only shown once its port list turns out to be non-empty */
+			st->show = false;
+			st->out = open_memstream(&st->buf, &st->len);
+			if (!st->out)
+				return;
+			fprintf(st->out, "VLAN %d:\n", val->port_vlan);
+			break;
+		}
+	}
+
+	if (attr->atype == SWLIB_ATTR_GROUP_VLAN && !strcmp(attr->name, "ports") &&
+	    !val->err && val->len)
+		st->show = true;
+
+	fprintf(st->out, "\t%s: ", attr->name);
+	if (val->err)
+		fprintf(st->out, "???");
+	else
+		print_attr_val(st->out, attr, val);
+	fputc('\n', st->out);
+	st->count++;
+}
+
+/*
+ * fetch all values with a single dump, *shown tells whether anything was
+ * printed before an error, in which case the caller cannot fall back
+ */
+static int
+show_all(struct switch_dev *dev, bool *shown)
+{
+	struct show_state st;
+	int ret;
+
+	memset(&st, 0, sizeof(st));
+	ret = swlib_get_all(dev, show_value, &st);
+	show_section_end(&st);
+
+	*shown = st.count > 0;
+	if (ret < 0 && *shown)
+		nl_perror(-ret, "Failed to show all attributes");
+
+	return ret < 0 ? ret : 0;
+}
+
 static void
 print_usage(void)
 {
 	printf("swconfig list\n");
-	printf("swconfig dev <dev> [port <port>|vlan <vlan>] (help|set <key> <value>|get <key>|load <config>|show)\n");
+	printf("swconfig dev <dev> [port <port>|vlan <vlan>] (help|set <key> <value>|get <key>|load <config>|show|monitor)\n");
 	exit(1);
 }
 
@@ -238,6 +354,7 @@ int main(int argc, char **argv)
 	struct switch_dev *dev;
 	struct switch_attr *a;
 	struct switch_val val;
+	bool shown;
 	int i;
 
 	int cmd = CMD_NONE;
@@ -291,6 +408,10 @@ int main(int argc, char **argv)
 			cmd = CMD_PORTMAP;
 		} else if (!strcmp(arg, "show")) {
 			cmd = CMD_SHOW;
+		} else if (!strcmp(arg, "monitor")) {
+			if (cvlan >= 0)
+				print_usage();
+			cmd = CMD_MONITOR;
 		} else {
 			print_usage();
 		}
@@ -353,7 +474,7 @@ int main(int argc, char **argv)
 			nl_perror(-retval, "Failed to get attribute");
 			goto out;
 		}
-		print_attr_val(a, &val);
+		print_attr_val(stdout, a, &val);
 		putchar('\n');
 		break;
 	case CMD_LOAD:
@@ -371,7 +492,8 @@ int main(int argc, char **argv)
 				show_port(dev, cport);
 			else
 				show_vlan(dev, cvlan, false);
-		} else {
+		} else if ((retval = show_all(dev, &shown)) < 0 && !shown) {
+			retval = 0;
 			show_global(dev);
 			for (i=0; i < dev->ports; i++)
 				show_port(dev, i);
@@ -379,6 +501,11 @@ int main(int argc, char **argv)
 				show_vlan(dev, i, true);
 		}
 		break;
+	case CMD_MONITOR:
+		retval = swlib_monitor(dev, print_event, &cport);
+		if (retval < 0)
+			nl_perror(-retval, "Failed to monitor switch");
+		break;
 	}
 
 out:
@@ -28,6 +28,7 @@
 #include <netlink/netlink.h>
 #include <netlink/genl/genl.h>
 #include <netlink/genl/family.h>
+#include <netlink/genl/ctrl.h>
 
 //#define DEBUG 1
 #ifdef DEBUG
@@ -84,15 +85,29 @@ wait_handler(struct nl_msg *msg, void *arg)
 	return NL_STOP;
 }
 
+/* a dump aborted by the kernel ends with the error in its DONE message */
+static int
+dump_done_handler(struct nl_msg *msg, void *arg)
+{
+	struct nlmsghdr *nlh = nlmsg_hdr(msg);
+	int *finished = arg;
+	int err = 0;
+
+	if (nlmsg_datalen(nlh) >= sizeof(err))
+		memcpy(&err, nlmsg_data(nlh), sizeof(err));
+
+	*finished = err < 0 ? -nl_syserr2nlerr(-err) : 1;
+	return NL_STOP;
+}
+
 /* helper function for performing netlink requests */
 static int
-swlib_call(int cmd, int (*call)(struct nl_msg *, void *),
+__swlib_call(int cmd, int flags, int (*call)(struct nl_msg *, void *),
 		int (*data)(struct nl_msg *, void *), void *arg)
 {
 	struct nl_msg *msg;
 	struct nl_cb *cb = NULL;
 	int finished;
-	int flags = 0;
 	int err = 0;
 
 	msg = nlmsg_alloc();
@@ -101,9 +116,6 @@ swlib_call(int cmd, int (*call)(struct nl_msg *, void *),
 		exit(1);
 	}
 
-	if (!data)
-		flags |= NLM_F_DUMP;
-
 	genlmsg_put(msg, NL_AUTO_PID, NL_AUTO_SEQ, genl_family_get_id(family), 0, flags, cmd, 0);
 	if (data) {
 		err = data(msg, arg);
@@ -128,17 +140,19 @@ swlib_call(int cmd, int (*call)(struct nl_msg *, void *),
 	if (call)
 		nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, call, arg);
 
-	if (data)
-		nl_cb_set(cb, NL_CB_ACK, NL_CB_CUSTOM, wait_handler, &finished);
+	if (flags & NLM_F_DUMP)
+		nl_cb_set(cb, NL_CB_FINISH, NL_CB_CUSTOM, dump_done_handler, &finished);
 	else
-		nl_cb_set(cb, NL_CB_FINISH, NL_CB_CUSTOM, wait_handler, &finished);
+		nl_cb_set(cb, NL_CB_ACK, NL_CB_CUSTOM, wait_handler, &finished);
 
 	err = nl_recvmsgs(handle, cb);
 	if (err < 0) {
 		goto out;
 	}
 
-	if (!finished)
+	if (finished < 0)
+		err = finished;
+	else if (!finished)
 		err = nl_wait_for_ack(handle);
 
 out:
@@ -149,6 +163,13 @@ nla_put_failure:
 	return err;
 }
 
+static int
+swlib_call(int cmd, int (*call)(struct nl_msg *, void *),
+		int (*data)(struct nl_msg *, void *), void *arg)
+{
+	return __swlib_call(cmd, data ? 0 : NLM_F_DUMP, call, data, arg);
+}
+
 static int
 send_attr(struct nl_msg *msg, void *arg)
 {
@@ -304,6 +325,127 @@ swlib_get_attr(struct switch_dev *dev, struct switch_attr *attr, struct switch_v
 	return err;
 }
 
+struct monitor_arg {
+	struct switch_dev *dev;
+	int (*cb)(const struct switch_event *ev, void *arg);
+	void *arg;
+	int ret;
+};
+
+static int
+no_seq_check(struct nl_msg *msg, void *arg)
+{
+	return NL_OK;
+}
+
+static int
+store_event(struct nl_msg *msg, void *arg)
+{
+	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+	struct monitor_arg *ma = arg;
+	struct switch_event ev;
+	struct switch_val val;
+
+	if (nla_parse(tb, SWITCH_ATTR_MAX - 1, genlmsg_attrdata(gnlh, 0),
+			genlmsg_attrlen(gnlh, 0), NULL) < 0)
+		goto done;
+
+	if (!tb[SWITCH_ATTR_ID] || !tb[SWITCH_ATTR_OP_PORT])
+		goto done;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.id = nla_get_u32(tb[SWITCH_ATTR_ID]);
+	if (ma->dev && ev.id != ma->dev->id)
+		goto done;
+
+	ev.port = nla_get_u32(tb[SWITCH_ATTR_OP_PORT]);
+	if (tb[SWITCH_ATTR_DEV_NAME])
+		strncpy(ev.dev_name, nla_get_string(tb[SWITCH_ATTR_DEV_NAME]),
+			IFNAMSIZ - 1);
+
+	switch (gnlh->cmd) {
+	case SWITCH_CMD_LINK_EVENT:
+		if (!tb[SWITCH_ATTR_OP_VALUE_LINK])
+			goto done;
+
+		memset(&val, 0, sizeof(val));
+		val.value.link = &ev.link;
+		if (store_link_val(msg, tb[SWITCH_ATTR_OP_VALUE_LINK], &val) < 0)
+			goto done;
+
+		ev.type = SWLIB_EVENT_LINK;
+		break;
+	case SWITCH_CMD_STATS_EVENT:
+		if (tb[SWITCH_ATTR_STATS_TX_BYTES])
+			ev.tx_bytes = nla_get_u64(tb[SWITCH_ATTR_STATS_TX_BYTES]);
+		if (tb[SWITCH_ATTR_STATS_RX_BYTES])
+			ev.rx_bytes = nla_get_u64(tb[SWITCH_ATTR_STATS_RX_BYTES]);
+
+		ev.type = SWLIB_EVENT_STATS;
+		break;
+	default:
+		goto done;
+	}
+
+	ma->ret = ma->cb(&ev, ma->arg);
+	if (ma->ret)
+		return NL_STOP;
+
+done:
+	return NL_SKIP;
+}
+
+int
+swlib_monitor(struct switch_dev *dev,
+		int (*cb)(const struct switch_event *ev, void *arg), void *arg)
+{
+	struct monitor_arg ma = {
+		.dev = dev,
+		.cb = cb,
+		.arg = arg,
+	};
+	struct nl_sock *sock;
+	struct nl_cb *ncb;
+	int err;
+
+	/* use a separate socket, so that the callback can still issue requests */
+	sock = nl_socket_alloc();
+	if (!sock)
+		return -NLE_NOMEM;
+
+	err = genl_connect(sock);
+	if (err < 0)
+		goto out;
+
+	err = genl_ctrl_resolve_grp(sock, "switch", SWITCH_MCGRP_EVENTS);
+	if (err < 0)
+		goto out;
+
+	err = nl_socket_add_membership(sock, err);
+	if (err < 0)
+		goto out;
+
+	ncb = nl_cb_alloc(NL_CB_CUSTOM);
+	if (!ncb) {
+		err = -NLE_NOMEM;
+		goto out;
+	}
+
+	nl_cb_set(ncb, NL_CB_SEQ_CHECK, NL_CB_CUSTOM, no_seq_check, NULL);
+	nl_cb_set(ncb, NL_CB_VALID, NL_CB_CUSTOM, store_event, &ma);
+
+	while (!ma.ret) {
+		err = nl_recvmsgs(sock, ncb);
+		if (err < 0)
+			break;
+	}
+
+	nl_cb_put(ncb);
+out:
+	nl_socket_free(sock);
+	return err < 0 ? err : ma.ret;
+}
+
 static int
 send_attr_ports(struct nl_msg *msg, struct switch_val *val)
 {
@@ -429,27 +571,30 @@ enum {
 	CMD_SPEED,
 };
 
-int swlib_set_attr_string(struct switch_dev *dev, struct switch_attr *a, int port_vlan, const char *str)
+int swlib_parse_attr_string(struct switch_dev *dev, struct switch_attr *a,
+		int port_vlan, const char *str, struct switch_val *val)
 {
 	struct switch_port *ports;
 	struct switch_port_link *link;
-	struct switch_val val;
 	char *ptr;
 	int cmd = CMD_NONE;
 
-	memset(&val, 0, sizeof(val));
-	val.port_vlan = port_vlan;
+	memset(val, 0, sizeof(*val));
+	val->attr = a;
+	val->port_vlan = port_vlan;
 	switch(a->type) {
 	case SWITCH_TYPE_INT:
-		val.value.i = atoi(str);
+		val->value.i = atoi(str);
 		break;
 	case SWITCH_TYPE_STRING:
-		val.value.s = (char *)str;
+		val->value.s = (char *)str;
 		break;
 	case SWITCH_TYPE_PORTS:
-		ports = alloca(sizeof(struct switch_port) * dev->ports);
-		memset(ports, 0, sizeof(struct switch_port) * dev->ports);
-		val.len = 0;
+		ports = swlib_alloc(sizeof(struct switch_port) * dev->ports);
+		if (!ports)
+			return -1;
+		val->value.ports = ports;
+		val->len = 0;
 		ptr = (char *)str;
 		while(ptr && *ptr)
 		{
@@ -460,30 +605,30 @@ int swlib_set_attr_string(struct switch_dev *dev, struct switch_attr *a, int por
 				break;
 
 			if (!isdigit(*ptr))
-				return -1;
+				goto error;
 
-			if (val.len >= dev->ports)
-				return -1;
+			if (val->len >= dev->ports)
+				goto error;
 
-			ports[val.len].flags = 0;
-			ports[val.len].id = strtoul(ptr, &ptr, 10);
+			ports[val->len].flags = 0;
+			ports[val->len].id = strtoul(ptr, &ptr, 10);
 			while(*ptr && !isspace(*ptr)) {
 				if (*ptr == 't')
-					ports[val.len].flags |= SWLIB_PORT_FLAG_TAGGED;
+					ports[val->len].flags |= SWLIB_PORT_FLAG_TAGGED;
 				else
-					return -1;
+					goto error;
 
 				ptr++;
 			}
 			if (*ptr)
 				ptr++;
-			val.len++;
+			val->len++;
 		}
-		val.value.ports = ports;
 		break;
 	case SWITCH_TYPE_LINK:
-		link = malloc(sizeof(struct switch_port_link));
-		memset(link, 0, sizeof(struct switch_port_link));
+		link = swlib_alloc(sizeof(struct switch_port_link));
+		if (!link)
+			return -1;
 		ptr = (char *)str;
 		for (ptr = strtok(ptr," "); ptr; ptr = strtok(NULL, " ")) {
 			switch (cmd) {
@@ -521,17 +666,271 @@ int swlib_set_attr_string(struct switch_dev *dev, struct switch_attr *a, int por
 				break;
 			}
 		}
-		val.value.link = link;
+		val->value.link = link;
 		break;
 	case SWITCH_TYPE_NOVAL:
 		if (str && !strcmp(str, "0"))
-			return 0;
+			return 1;
 
 		break;
 	default:
 		return -1;
 	}
-	return swlib_set_attr(dev, a, &val);
+	return 0;
+
+error:
+	swlib_free_val(val);
+	return -1;
+}
+
+void swlib_free_val(struct switch_val *val)
+{
+	switch (val->attr->type) {
+	case SWITCH_TYPE_PORTS:
+		free(val->value.ports);
+		break;
+	case SWITCH_TYPE_LINK:
+		free(val->value.link);
+		break;
+	default:
+		break;
+	}
+	memset(&val->value, 0, sizeof(val->value));
+}
+
+int swlib_set_attr_string(struct switch_dev *dev, struct switch_attr *a, int port_vlan, const char *str)
+{
+	struct switch_val val;
+	int ret;
+
+	ret = swlib_parse_attr_string(dev, a, port_vlan, str, &val);
+	if (ret)
+		return ret < 0 ? ret : 0;
+
+	ret = swlib_set_attr(dev, a, &val);
+	swlib_free_val(&val);
+
+	return ret;
+}
+
+struct bulk_arg {
+	struct switch_dev *dev;
+	struct switch_val *vals;
+	int n;
+	int idx;
+};
+
+static int
+send_bulk(struct nl_msg *msg, void *arg)
+{
+	struct bulk_arg *b = arg;
+	struct nlmsghdr *nlh = nlmsg_hdr(msg);
+	struct nlattr *ops, *op;
+	uint32_t len;
+	int start = b->idx;
+
+	NLA_PUT_U32(msg, SWITCH_ATTR_ID, b->dev->id);
+
+	ops = nla_nest_start(msg, SWITCH_ATTR_OPS);
+	if (!ops)
+		goto nla_put_failure;
+
+	for (; b->idx < b->n; b->idx++) {
+		struct switch_val *val = &b->vals[b->idx];
+		int cmd;
+
+		switch (val->attr->atype) {
+		case SWLIB_ATTR_GROUP_GLOBAL:
+			cmd = SWITCH_CMD_SET_GLOBAL;
+			break;
+		case SWLIB_ATTR_GROUP_PORT:
+			cmd = SWITCH_CMD_SET_PORT;
+			break;
+		case SWLIB_ATTR_GROUP_VLAN:
+			cmd = SWITCH_CMD_SET_VLAN;
+			break;
+		default:
+			continue;
+		}
+
+		/* stop at the first operation which no longer fits */
+		len = nlh->nlmsg_len;
+		op = nla_nest_start(msg, b->idx - start + 1);
+		if (!op)
+			break;
+		if (nla_put_u32(msg, SWITCH_ATTR_OP_CMD, cmd) < 0 ||
+		    send_attr_val(msg, val) < 0) {
+			nlh->nlmsg_len = len;
+			break;
+		}
+		nla_nest_end(msg, op);
+	}
+
+	if (b->idx == start)
+		goto nla_put_failure;
+
+	nla_nest_end(msg, ops);
+	return 0;
+
+nla_put_failure:
+	return -1;
+}
+
+int
+swlib_set_attr_bulk(struct switch_dev *dev, struct switch_val *vals, int n)
+{
+	struct bulk_arg arg = {
+		.dev = dev,
+		.vals = vals,
+		.n = n,
+	};
+	int ret = 0;
+	int err;
+
+	while (arg.idx < n) {
+		int start = arg.idx;
+
+		err = swlib_call(SWITCH_CMD_SET_BULK, NULL, send_bulk, &arg);
+		if (err == -NLE_OPNOTSUPP && !start) {
+			/* kernel without bulk support, set them one by one */
+			arg.idx = 0;
+			break;
+		}
+
+		/* too large for a single message on its own */
+		if (arg.idx == start) {
+			err = swlib_set_attr(dev, vals[start].attr, &vals[start]);
+			arg.idx++;
+		}
+
+		if (err < 0 && !ret)
+			ret = err;
+	}
+
+	for (; arg.idx < n; arg.idx++) {
+		struct switch_val *val = &vals[arg.idx];
+
+		err = swlib_set_attr(dev, val->attr, val);
+		if (err < 0 && !ret)
+			ret = err;
+	}
+
+	return ret;
+}
+
+struct get_all_arg {
+	struct switch_dev *dev;
+	void (*cb)(struct switch_attr *attr, struct switch_val *val, void *arg);
+	void *arg;
+	struct switch_port *ports;
+};
+
+static int
+send_dev_id(struct nl_msg *msg, void *arg)
+{
+	struct get_all_arg *ga = arg;
+
+	NLA_PUT_U32(msg, SWITCH_ATTR_ID, ga->dev->id);
+
+	return 0;
+nla_put_failure:
+	return -1;
+}
+
+static struct switch_attr *
+swlib_find_attr(struct switch_attr *head, int id)
+{
+	for (; head; head = head->next)
+		if (head->id == id)
+			return head;
+
+	return NULL;
+}
+
+static int
+store_all(struct nl_msg *msg, void *arg)
+{
+	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+	struct get_all_arg *ga = arg;
+	struct switch_port_link link;
+	struct switch_attr *head;
+	struct switch_val val;
+
+	if (nla_parse(tb, SWITCH_ATTR_MAX - 1, genlmsg_attrdata(gnlh, 0),
+			genlmsg_attrlen(gnlh, 0), NULL) < 0)
+		goto done;
+
+	if (!tb[SWITCH_ATTR_OP_CMD] || !tb[SWITCH_ATTR_OP_ID])
+		goto done;
+
+	memset(&val, 0, sizeof(val));
+	switch (nla_get_u32(tb[SWITCH_ATTR_OP_CMD])) {
+	case SWITCH_CMD_GET_GLOBAL:
+		head = ga->dev->ops;
+		break;
+	case SWITCH_CMD_GET_PORT:
+		if (!tb[SWITCH_ATTR_OP_PORT])
+			goto done;
+		head = ga->dev->port_ops;
+		val.port_vlan = nla_get_u32(tb[SWITCH_ATTR_OP_PORT]);
+		break;
+	case SWITCH_CMD_GET_VLAN:
+		if (!tb[SWITCH_ATTR_OP_VLAN])
+			goto done;
+		head = ga->dev->vlan_ops;
+		val.port_vlan = nla_get_u32(tb[SWITCH_ATTR_OP_VLAN]);
+		break;
+	default:
+		goto done;
+	}
+
+	val.attr = swlib_find_attr(head, nla_get_u32(tb[SWITCH_ATTR_OP_ID]));
+	if (!val.attr)
+		goto done;
+
+	/* string values are only valid during the callback */
+	val.err = 0;
+	if (tb[SWITCH_ATTR_OP_VALUE_INT]) {
+		val.value.i = nla_get_u32(tb[SWITCH_ATTR_OP_VALUE_INT]);
+	} else if (tb[SWITCH_ATTR_OP_VALUE_STR]) {
+		val.value.s = nla_get_string(tb[SWITCH_ATTR_OP_VALUE_STR]);
+	} else if (tb[SWITCH_ATTR_OP_VALUE_PORTS]) {
+		val.value.ports = ga->ports;
+		val.err = store_port_val(msg, tb[SWITCH_ATTR_OP_VALUE_PORTS], &val);
+	} else if (tb[SWITCH_ATTR_OP_VALUE_LINK]) {
+		val.value.link = &link;
+		val.err = store_link_val(msg, tb[SWITCH_ATTR_OP_VALUE_LINK], &val);
+	} else {
+		val.err = -EINVAL;
+	}
+
+	ga->cb(val.attr, &val, ga->arg);
+
+done:
+	return NL_SKIP;
+}
+
+int
+swlib_get_all(struct switch_dev *dev,
+		void (*cb)(struct switch_attr *attr, struct switch_val *val, void *arg),
+		void *arg)
+{
+	struct get_all_arg ga = {
+		.dev = dev,
+		.cb = cb,
+		.arg = arg,
+	};
+	int err;
+
+	ga.ports = swlib_alloc(sizeof(struct switch_port) * (dev->ports + 1));
+	if (!ga.ports)
+		return -NLE_NOMEM;
+
+	err = __swlib_call(SWITCH_CMD_GET_BULK, NLM_F_DUMP, store_all,
+			send_dev_id, &ga);
+	free(ga.ports);
+
+	return err;
 }
 
 
@@ -52,6 +52,13 @@ Usage of the library functions:
   switch_set_attr() and switch_get_attr() can alter or request the values
   of attributes.
 
+  swlib_set_attr_bulk() and swlib_get_all() do the same for many attributes
+  at once, with a single request instead of one per attribute.
+
+  Instead of polling the link attribute of every port, swlib_monitor() can
+  be used to receive link changes (and counter deltas, if enabled in the
+  kernel) as they are reported by the switch driver.
+
 Usage of the switch_attr struct:
 
   ->atype: attribute group, one of:
@@ -178,6 +185,23 @@ struct switch_port_link {
 	uint32_t eee;
 };
 
+enum swlib_event_type {
+	SWLIB_EVENT_LINK,
+	SWLIB_EVENT_STATS,
+};
+
+struct switch_event {
+	int type;
+	int id;
+	char dev_name[IFNAMSIZ];
+	int port;
+	/* SWLIB_EVENT_LINK */
+	struct switch_port_link link;
+	/* SWLIB_EVENT_STATS, since the previous event for this port */
+	unsigned long long tx_bytes;
+	unsigned long long rx_bytes;
+};
+
 /**
  * swlib_list: list all switches
  */
@@ -248,6 +272,34 @@ int swlib_set_attr(struct switch_dev *dev, struct switch_attr *attr,
 int swlib_set_attr_string(struct switch_dev *dev, struct switch_attr *attr,
 		int port_vlan, const char *str);
 
+/**
+ * swlib_parse_attr_string: convert a string into an attribute value
+ * @dev: switch device struct
+ * @attr: switch attribute struct
+ * @port_vlan: port or vlan (if applicable)
+ * @str: string value
+ * @val: attribute value pointer, to be released with swlib_free_val()
+ * returns 0 on success, 1 if there is nothing to set
+ */
+int swlib_parse_attr_string(struct switch_dev *dev, struct switch_attr *attr,
+		int port_vlan, const char *str, struct switch_val *val);
+
+/**
+ * swlib_free_val: free the data allocated by swlib_parse_attr_string
+ * @val: attribute value pointer
+ */
+void swlib_free_val(struct switch_val *val);
+
+/**
+ * swlib_set_attr_bulk: set the values for a list of attributes
+ * @dev: switch device struct
+ * @vals: attribute values, ->attr and ->port_vlan must be set up
+ * @n: number of values
+ * returns 0 on success, or the first error
+ * all values are set in order, regardless of errors
+ */
+int swlib_set_attr_bulk(struct switch_dev *dev, struct switch_val *vals, int n);
+
 /**
  * swlib_get_attr: get the value for an attribute
  * @dev: switch device struct
@@ -259,6 +311,29 @@ int swlib_set_attr_string(struct switch_dev *dev, struct switch_attr *attr,
 int swlib_get_attr(struct switch_dev *dev, struct switch_attr *attr,
 		struct switch_val *val);
 
+/**
+ * swlib_get_all: get the values of all global, port and vlan attributes
+ * @dev: switch device struct
+ * @cb: called for every value in the order of the attribute lists,
+ *      val->err is set if the attribute could not be read
+ * @arg: passed to @cb
+ * returns 0 on success, an error if the dump failed, even after @cb was called
+ * values are only valid during the callback, swlib_scan() must be called first
+ */
+int swlib_get_all(struct switch_dev *dev,
+		void (*cb)(struct switch_attr *attr, struct switch_val *val, void *arg),
+		void *arg);
+
+/**
+ * swlib_monitor: receive link and counter events
+ * @dev: switch device struct, or NULL for events of all switches
+ * @cb: called for every event, monitoring stops when it returns non-zero
+ * @arg: passed to @cb
+ * returns the value returned by @cb, or a negative error code
+ */
+int swlib_monitor(struct switch_dev *dev,
+		int (*cb)(const struct switch_event *ev, void *arg), void *arg);
+
 /**
  * swlib_apply_from_uci: set up the switch from a uci configuration
  * @dev: switch device struct
@@ -112,8 +112,9 @@ int swlib_apply_from_uci(struct switch_dev *dev, struct uci_package *p)
 	struct uci_section *s;
 	struct uci_option *o;
 	struct uci_ptr ptr;
-	struct switch_val val;
-	int i;
+	struct swlib_setting *st;
+	struct switch_val *vals;
+	int i, n;
 
 	settings = NULL;
 	head = &settings;
@@ -217,30 +218,44 @@ found:
 		}
 	}
 
+	/* early settings, the rest in config order and the final apply */
+	n = ARRAY_SIZE(early_settings) + 1;
+	for (st = settings; st; st = st->next)
+		n++;
+
+	vals = calloc(n, sizeof(*vals));
+	if (!vals)
+		return -1;
+
+	n = 0;
 	for (i = 0; i < ARRAY_SIZE(early_settings); i++) {
-		struct swlib_setting *st = &early_settings[i];
+		st = &early_settings[i];
 		if (!st->attr || !st->val)
 			continue;
-		swlib_set_attr_string(dev, st->attr, st->port_vlan, st->val);
-
+		if (!swlib_parse_attr_string(dev, st->attr, st->port_vlan, st->val, &vals[n]))
+			n++;
 	}
 
 	while (settings) {
-		struct swlib_setting *st = settings;
+		st = settings;
 
-		swlib_set_attr_string(dev, st->attr, st->port_vlan, st->val);
-		st = st->next;
-		free(settings);
-		settings = st;
+		if (!swlib_parse_attr_string(dev, st->attr, st->port_vlan, st->val, &vals[n]))
+			n++;
+		settings = st->next;
+		free(st);
 	}
 
 	/* Apply the config */
 	attr = swlib_lookup_attr(dev, SWLIB_ATTR_GROUP_GLOBAL, "apply");
-	if (!attr)
-		return 0;
+	if (attr)
+		vals[n++].attr = attr;
+
+	/* send everything with as few requests as possible */
+	swlib_set_attr_bulk(dev, vals, n);
 
-	memset(&val, 0, sizeof(val));
-	swlib_set_attr(dev, attr, &val);
+	for (i = 0; i < n; i++)
+		swlib_free_val(&vals[i]);
+	free(vals);
 
 	return 0;
 }
@@ -706,6 +706,9 @@ ead_pcap_reopen(bool first)
 		if (!pcap_fp)
 			sleep(1);
 	} while (!pcap_fp);
+
+	/* let the kernel drop everything not addressed to this node */
+	pktfilter_insns[PKTFILTER_NID_INSN].k = nid;
 	pcap_setfilter(pcap_fp_rx, &pktfilter);
 }
 
@@ -714,7 +717,7 @@ static void
 ead_pktloop(void)
 {
 	while (1) {
-		if (pcap_dispatch(pcap_fp_rx, 1, handle_packet, NULL) < 0) {
+		if (pcap_dispatch(pcap_fp_rx, -1, handle_packet, NULL) < 0) {
 			ead_pcap_reopen(false);
 			continue;
 		}
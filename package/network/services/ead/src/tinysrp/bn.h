@@ -74,7 +74,7 @@ extern "C" {
 #undef BN_SQR_COMBA
 #undef BN_RECURSION
 #undef RECP_MUL_MOD
-#undef MONT_MUL_MOD
+#define MONT_MUL_MOD
 
 #if defined(SIZEOF_LONG_LONG) && SIZEOF_LONG_LONG == 8
 # if SIZEOF_LONG == 4
@@ -88,7 +88,13 @@ extern "C" {
 # endif
 #endif
 
+/* Let the compiler do 32x32->64 bit multiplies on 32 bit targets,
+ * they map onto multu/umull on MIPS and ARM. */
+#ifdef THIRTY_TWO_BIT
+#define BN_LLONG
+#else
 #undef BN_LLONG
+#endif
 
 /* assuming long is 64bit - this is the DEC Alpha
  * unsigned long long is only 64 bits :-(, don't define
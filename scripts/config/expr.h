@@ -81,8 +81,8 @@ enum {
  * SYMBOL_CHOICE bit set in 'flags'.
  */
 struct symbol {
-	/* The next symbol in the same bucket in the symbol hash table */
-	struct symbol *next;
+	/* Full hash of 'name', compared before the name when probing */
+	unsigned int hash;
 
 	/* The name of the symbol, e.g. "FOO" for 'config FOO' */
 	char *name;
@@ -131,7 +131,7 @@ struct symbol {
 	struct expr_value implied;
 };
 
-#define for_all_symbols(i, sym) for (i = 0; i < SYMBOL_HASHSIZE; i++) for (sym = symbol_hash[i]; sym; sym = sym->next)
+#define for_all_symbols(i, sym) for (i = 0; i < symbol_hash_size; i++) if (!(sym = symbol_hash[i])) {} else
 
 #define SYMBOL_CONST      0x0001  /* symbol is const */
 #define SYMBOL_CHECK      0x0008  /* used during dependency checking */
@@ -160,7 +160,7 @@ struct symbol {
 #define SYMBOL_ALLNOCONFIG_Y 0x200000
 
 #define SYMBOL_MAXLENGTH	256
-#define SYMBOL_HASHSIZE		9973
+#define SYMBOL_HASHSIZE		8192	/* initial size, must be a power of 2 */
 
 /* A property represent the config options that can be associated
  * with a config "symbol".
@@ -28,7 +28,8 @@ struct gstr get_relations_str(struct symbol **sym_arr, struct list_head *head);
 void menu_get_ext_help(struct menu *menu, struct gstr *help);
 
 /* symbol.c */
-extern struct symbol * symbol_hash[SYMBOL_HASHSIZE];
+extern struct symbol **symbol_hash;
+extern unsigned int symbol_hash_size;
 
 struct symbol * sym_lookup(const char *name, int flags);
 struct symbol * sym_find(const char *name);
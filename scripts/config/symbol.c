@@ -779,11 +779,42 @@ static unsigned strhash(const char *s)
 	return hash;
 }
 
+/*
+ * The symbol table uses open addressing with linear probing. It starts at
+ * SYMBOL_HASHSIZE slots and doubles once it is half full, so probe
+ * sequences stay short however many symbols the tree declares.
+ */
+static unsigned int symbol_hash_count;
+
+static void sym_hash_insert(struct symbol *sym)
+{
+	unsigned int mask = symbol_hash_size - 1;
+	unsigned int i = sym->hash & mask;
+
+	while (symbol_hash[i])
+		i = (i + 1) & mask;
+	symbol_hash[i] = sym;
+}
+
+static void sym_hash_grow(void)
+{
+	struct symbol **old_hash = symbol_hash;
+	unsigned int old_size = symbol_hash_size;
+	unsigned int i;
+
+	symbol_hash_size = old_size ? old_size * 2 : SYMBOL_HASHSIZE;
+	symbol_hash = xcalloc(symbol_hash_size, sizeof(*symbol_hash));
+	for (i = 0; i < old_size; i++)
+		if (old_hash[i])
+			sym_hash_insert(old_hash[i]);
+	free(old_hash);
+}
+
 struct symbol *sym_lookup(const char *name, int flags)
 {
 	struct symbol *symbol;
 	char *new_name;
-	int hash;
+	unsigned int hash, i;
 
 	if (name) {
 		if (name[0] && !name[1]) {
@@ -793,10 +824,13 @@ struct symbol *sym_lookup(const char *name, int flags)
 			case 'n': return &symbol_no;
 			}
 		}
-		hash = strhash(name) % SYMBOL_HASHSIZE;
+		hash = strhash(name);
 
-		for (symbol = symbol_hash[hash]; symbol; symbol = symbol->next) {
-			if (symbol->name &&
+		for (i = hash & (symbol_hash_size - 1);
+		     symbol_hash_size && (symbol = symbol_hash[i]);
+		     i = (i + 1) & (symbol_hash_size - 1)) {
+			if (symbol->hash == hash &&
+			    symbol->name &&
 			    !strcmp(symbol->name, name) &&
 			    (flags ? symbol->flags & flags
 				   : !(symbol->flags & (SYMBOL_CONST|SYMBOL_CHOICE))))
@@ -804,26 +838,33 @@ struct symbol *sym_lookup(const char *name, int flags)
 		}
 		new_name = xstrdup(name);
 	} else {
+		/*
+		 * Nameless choices are never looked up, just spread them
+		 * over the table instead of piling them up in one cluster.
+		 */
 		new_name = NULL;
-		hash = 0;
+		hash = symbol_hash_count * 0x9e3779b1U;
 	}
 
 	symbol = xmalloc(sizeof(*symbol));
 	memset(symbol, 0, sizeof(*symbol));
 	symbol->name = new_name;
+	symbol->hash = hash;
 	symbol->type = S_UNKNOWN;
 	symbol->flags |= flags;
 
-	symbol->next = symbol_hash[hash];
-	symbol_hash[hash] = symbol;
+	if ((symbol_hash_count + 1) * 2 > symbol_hash_size)
+		sym_hash_grow();
+	sym_hash_insert(symbol);
+	symbol_hash_count++;
 
 	return symbol;
 }
 
 struct symbol *sym_find(const char *name)
 {
-	struct symbol *symbol = NULL;
-	int hash = 0;
+	struct symbol *symbol;
+	unsigned int hash, i;
 
 	if (!name)
 		return NULL;
@@ -835,13 +876,18 @@ struct symbol *sym_find(const char *name)
 		case 'n': return &symbol_no;
 		}
 	}
-	hash = strhash(name) % SYMBOL_HASHSIZE;
+	if (!symbol_hash_size)
+		return NULL;
+	hash = strhash(name);
 
-	for (symbol = symbol_hash[hash]; symbol; symbol = symbol->next) {
-		if (symbol->name &&
+	for (i = hash & (symbol_hash_size - 1);
+	     (symbol = symbol_hash[i]);
+	     i = (i + 1) & (symbol_hash_size - 1)) {
+		if (symbol->hash == hash &&
+		    symbol->name &&
 		    !strcmp(symbol->name, name) &&
 		    !(symbol->flags & SYMBOL_CONST))
-				break;
+			break;
 	}
 
 	return symbol;
@@ -48,6 +48,8 @@
  * possibly gain from saving instructions.
  */
 #define AG71XX_NAPI_WEIGHT	32
+/* log2 buckets of RX packets handled per poll: 0, 1, 2-3, ... 16-31, 32 */
+#define AG71XX_RX_BATCH_BINS	7
 #define AG71XX_OOM_REFILL	(1 + HZ/10)
 
 #define AG71XX_INT_ERR	(AG71XX_INT_RX_BE | AG71XX_INT_TX_BE)
@@ -65,8 +67,8 @@
 #define AG71XX_TX_RING_SIZE_DEFAULT	128
 #define AG71XX_RX_RING_SIZE_DEFAULT	256
 
-#define AG71XX_TX_RING_SIZE_MAX		128
-#define AG71XX_RX_RING_SIZE_MAX		256
+#define AG71XX_TX_RING_SIZE_MAX		512
+#define AG71XX_RX_RING_SIZE_MAX		1024
 
 #ifdef CONFIG_AG71XX_DEBUG
 #define DBG(fmt, args...)	pr_debug(fmt, ## args)
@@ -166,6 +168,7 @@ struct ag71xx {
 	spinlock_t		lock;
 	struct napi_struct	napi;
 	u32			msg_enable;
+	u64			rx_batch[AG71XX_RX_BATCH_BINS];
 
 	/*
 	 * From this point onwards we're not looking at per-packet fields.
@@ -212,6 +215,7 @@ struct ag71xx_mdio {
 
 extern struct ethtool_ops ag71xx_ethtool_ops;
 void ag71xx_link_adjust(struct ag71xx *ag);
+int ag71xx_rings_reinit(struct ag71xx *ag, u16 tx_order, u16 rx_order);
 
 int ag71xx_phy_connect(struct ag71xx *ag);
 void ag71xx_phy_disconnect(struct ag71xx *ag);
@@ -394,6 +398,16 @@ static inline void ag71xx_wr(struct ag71xx *ag, unsigned reg, u32 value)
 	(void) __raw_readl(ag->mac_base + reg);
 }
 
+/* write the same value several times, e.g. to ack counters, flush once */
+static inline void ag71xx_wr_rep(struct ag71xx *ag, unsigned reg, u32 value,
+				 int count)
+{
+	while (count--)
+		__raw_writel(value, ag->mac_base + reg);
+	/* flush writes */
+	(void) __raw_readl(ag->mac_base + reg);
+}
+
 static inline u32 ag71xx_rr(struct ag71xx *ag, unsigned reg)
 {
 	return __raw_readl(ag->mac_base + reg);
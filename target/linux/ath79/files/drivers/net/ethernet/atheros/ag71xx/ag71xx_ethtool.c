@@ -66,6 +66,12 @@ static const struct ag71xx_statistic ag71xx_statistics[] = {
 	{ 0x012C, GENMASK(11, 0), "Tx Fragment", },
 };
 
+/* names of the per-poll RX batch size histogram bins, see ag71xx_poll() */
+static const char ag71xx_rx_batch_names[][ETH_GSTRING_LEN] = {
+	"RX batch 0", "RX batch 1", "RX batch 2-3", "RX batch 4-7",
+	"RX batch 8-15", "RX batch 16-31", "RX batch 32",
+};
+
 static u32 ag71xx_ethtool_get_msglevel(struct net_device *dev)
 {
 	struct ag71xx *ag = netdev_priv(dev);
@@ -105,7 +111,6 @@ static int ag71xx_ethtool_set_ringparam(struct net_device *dev,
 	struct ag71xx *ag = netdev_priv(dev);
 	unsigned tx_size;
 	unsigned rx_size;
-	int err = 0;
 
 	if (er->rx_mini_pending != 0||
 	    er->rx_jumbo_pending != 0 ||
@@ -119,22 +124,12 @@ static int ag71xx_ethtool_set_ringparam(struct net_device *dev,
 	rx_size = er->rx_pending < AG71XX_RX_RING_SIZE_MAX ?
 		  er->rx_pending : AG71XX_RX_RING_SIZE_MAX;
 
-	if (netif_running(dev)) {
-		err = dev->netdev_ops->ndo_stop(dev);
-		if (err)
-			return err;
-	}
-
 	if (ag->tx_ring.desc_split)
 		tx_size *= AG71XX_TX_RING_DS_PER_PKT;
 
-	ag->tx_ring.order = ag71xx_ring_size_order(tx_size);
-	ag->rx_ring.order = ag71xx_ring_size_order(rx_size);
-
-	if (netif_running(dev))
-		err = dev->netdev_ops->ndo_open(dev);
-
-	return err;
+	/* swaps the rings without a link renegotiation */
+	return ag71xx_rings_reinit(ag, ag71xx_ring_size_order(tx_size),
+				   ag71xx_ring_size_order(rx_size));
 }
 
 static int ag71xx_ethtool_nway_reset(struct net_device *dev)
@@ -157,6 +152,10 @@ static void ag71xx_ethtool_get_strings(struct net_device *netdev, u32 sset,
 		for (i = 0; i < ARRAY_SIZE(ag71xx_statistics); i++)
 			memcpy(data + i * ETH_GSTRING_LEN,
 			       ag71xx_statistics[i].name, ETH_GSTRING_LEN);
+
+		data += ARRAY_SIZE(ag71xx_statistics) * ETH_GSTRING_LEN;
+		memcpy(data, ag71xx_rx_batch_names,
+		       sizeof(ag71xx_rx_batch_names));
 	}
 }
 
@@ -169,15 +168,20 @@ static void ag71xx_ethtool_get_stats(struct net_device *ndev,
 	for (i = 0; i < ARRAY_SIZE(ag71xx_statistics); i++)
 		*data++ = ag71xx_rr(ag, ag71xx_statistics[i].offset)
 				& ag71xx_statistics[i].mask;
+
+	for (i = 0; i < AG71XX_RX_BATCH_BINS; i++)
+		*data++ = ag->rx_batch[i];
 }
 
 static int ag71xx_ethtool_get_sset_count(struct net_device *ndev, int sset)
 {
 	if (sset == ETH_SS_STATS)
-		return ARRAY_SIZE(ag71xx_statistics);
+		return ARRAY_SIZE(ag71xx_statistics) + AG71XX_RX_BATCH_BINS;
 	return -EOPNOTSUPP;
 }
 
+static_assert(ARRAY_SIZE(ag71xx_rx_batch_names) == AG71XX_RX_BATCH_BINS);
+
 struct ethtool_ops ag71xx_ethtool_ops = {
 	.get_msglevel	= ag71xx_ethtool_get_msglevel,
 	.set_msglevel	= ag71xx_ethtool_set_msglevel,
@@ -41,6 +41,12 @@ static inline unsigned int ag71xx_max_frame_len(unsigned int mtu)
 	return ETH_SWITCH_HEADER_LEN + ETH_HLEN + VLAN_HLEN + mtu + ETH_FCS_LEN;
 }
 
+static inline unsigned int ag71xx_rx_buf_size(unsigned int mtu)
+{
+	return SKB_DATA_ALIGN(ag71xx_max_frame_len(mtu) + NET_SKB_PAD +
+			      NET_IP_ALIGN);
+}
+
 static void ag71xx_dump_dma_regs(struct ag71xx *ag)
 {
 	DBG("%s: dma_tx_ctrl=%08x, dma_tx_desc=%08x, dma_tx_status=%08x\n",
@@ -998,7 +1004,7 @@ static int ag71xx_open(struct net_device *dev)
 
 	netif_carrier_off(dev);
 	max_frame_len = ag71xx_max_frame_len(dev->mtu);
-	ag->rx_buf_size = SKB_DATA_ALIGN(max_frame_len + NET_SKB_PAD + NET_IP_ALIGN);
+	ag->rx_buf_size = ag71xx_rx_buf_size(dev->mtu);
 
 	/* setup max frame length */
 	ag71xx_wr(ag, AG71XX_REG_MAC_MFL, max_frame_len);
@@ -1219,6 +1225,66 @@ static void ag71xx_restart_work_func(struct work_struct *work)
 	rtnl_unlock();
 }
 
+/*
+ * Reallocate the rings of a running interface with new sizes and
+ * buffers matching the current MTU, without taking the PHY down.
+ * Must be called under RTNL.
+ */
+int ag71xx_rings_reinit(struct ag71xx *ag, u16 tx_order, u16 rx_order)
+{
+	struct net_device *dev = ag->dev;
+	u16 old_tx_order = ag->tx_ring.order;
+	u16 old_rx_order = ag->rx_ring.order;
+	unsigned int old_buf_size = ag->rx_buf_size;
+	unsigned long flags;
+	int ret;
+
+	ASSERT_RTNL();
+
+	if (!netif_running(dev)) {
+		ag->tx_ring.order = tx_order;
+		ag->rx_ring.order = rx_order;
+		return 0;
+	}
+
+	/* a queued restart would just redo the same */
+	cancel_delayed_work(&ag->restart_work);
+	ag71xx_hw_disable(ag);
+
+	ag->tx_ring.order = tx_order;
+	ag->rx_ring.order = rx_order;
+	ag->rx_buf_size = ag71xx_rx_buf_size(dev->mtu);
+
+	ret = ag71xx_hw_enable(ag);
+	if (ret) {
+		/* keep the interface usable with the previous setup */
+		ag71xx_rings_cleanup(ag);
+		ag->tx_ring.order = old_tx_order;
+		ag->rx_ring.order = old_rx_order;
+		ag->rx_buf_size = old_buf_size;
+
+		if (ag71xx_hw_enable(ag)) {
+			ag71xx_rings_cleanup(ag);
+			netdev_err(dev, "unable to reallocate rings\n");
+			/* ag71xx_stop expects napi to be enabled */
+			napi_enable(&ag->napi);
+			dev_close(dev);
+			return ret;
+		}
+	}
+
+	ag71xx_wr(ag, AG71XX_REG_MAC_MFL,
+		  min_t(unsigned int, ag71xx_max_frame_len(dev->mtu),
+			ag->rx_buf_size - NET_SKB_PAD - NET_IP_ALIGN));
+
+	spin_lock_irqsave(&ag->lock, flags);
+	if (ag->link)
+		__ag71xx_link_adjust(ag, false);
+	spin_unlock_irqrestore(&ag->lock, flags);
+
+	return ret;
+}
+
 static bool ag71xx_check_dma_stuck(struct ag71xx *ag)
 {
 	unsigned long timestamp;
@@ -1340,8 +1406,6 @@ static int ag71xx_rx_packets(struct ag71xx *ag, int limit)
 			break;
 		}
 
-		ag71xx_wr(ag, AG71XX_REG_RX_STATUS, RX_STATUS_PR);
-
 		pktlen = desc->ctrl & pktlen_mask;
 		pktlen -= ETH_FCS_LEN;
 
@@ -1364,6 +1428,11 @@ static int ag71xx_rx_packets(struct ag71xx *ag, int limit)
 			dev->stats.rx_dropped++;
 			kfree_skb(skb);
 		} else {
+			/*
+			 * The MAC does not verify L4 checksums and the
+			 * built-in switches do not report it in the frame
+			 * either, so the stack has to check them.
+			 */
 			skb->dev = dev;
 			skb->ip_summed = CHECKSUM_NONE;
 			list_add_tail(&skb->list, &rx_list);
@@ -1376,11 +1445,20 @@ next:
 		ring->curr++;
 	}
 
+	/*
+	 * Each write of RX_STATUS_PR decrements the received packet counter
+	 * by one, so ack the whole batch at once and flush a single time.
+	 */
+	if (done)
+		ag71xx_wr_rep(ag, AG71XX_REG_RX_STATUS, RX_STATUS_PR, done);
+
 	ag71xx_ring_rx_refill(ag);
 
-	list_for_each_entry_safe(skb, next, &rx_list, list)
+	list_for_each_entry_safe(skb, next, &rx_list, list) {
+		skb_list_del_init(skb);
 		skb->protocol = eth_type_trans(skb, dev);
-	netif_receive_skb_list(&rx_list);
+		napi_gro_receive(&ag->napi, skb);
+	}
 
 	DBG("%s: rx finish, curr=%u, dirty=%u, done=%d\n",
 		dev->name, ring->curr, ring->dirty, done);
@@ -1405,6 +1483,7 @@ static int ag71xx_poll(struct napi_struct *napi, int limit)
 	rx_done = ag71xx_rx_packets(ag, limit);
 
 	ag71xx_debugfs_update_napi_stats(ag, rx_done, tx_done);
+	ag->rx_batch[rx_done ? min(fls(rx_done), AG71XX_RX_BATCH_BINS - 1) : 0]++;
 
 	if (rx_ring->buf[rx_ring->dirty % rx_ring_size].rx_buf == NULL)
 		goto oom;
@@ -1489,12 +1568,26 @@ static irqreturn_t ag71xx_interrupt(int irq, void *dev_id)
 static int ag71xx_change_mtu(struct net_device *dev, int new_mtu)
 {
 	struct ag71xx *ag = netdev_priv(dev);
+	unsigned int old_mtu = dev->mtu;
+	int ret;
 
 	dev->mtu = new_mtu;
-	ag71xx_wr(ag, AG71XX_REG_MAC_MFL,
-		  ag71xx_max_frame_len(dev->mtu));
+	if (!netif_running(dev) ||
+	    ag71xx_rx_buf_size(new_mtu) == ag->rx_buf_size) {
+		ag71xx_wr(ag, AG71XX_REG_MAC_MFL,
+			  ag71xx_max_frame_len(dev->mtu));
+		return 0;
+	}
 
-	return 0;
+	/* the rx buffers were sized for the old MTU */
+	ret = ag71xx_rings_reinit(ag, ag->tx_ring.order, ag->rx_ring.order);
+	if (ret) {
+		dev->mtu = old_mtu;
+		ag71xx_wr(ag, AG71XX_REG_MAC_MFL,
+			  ag71xx_max_frame_len(dev->mtu));
+	}
+
+	return ret;
 }
 
 static const struct net_device_ops ag71xx_netdev_ops = {
@@ -170,11 +170,17 @@ struct bcm6368_enetsw {
 	/* next dirty rx descriptor to refill */
 	int rx_dirty_desc;
 
-	/* size of allocated rx skbs */
-	unsigned int rx_skb_size;
+	/* size of allocated rx buffers */
+	unsigned int rx_buf_size;
 
-	/* list of skb given to hw for rx */
-	struct sk_buff **rx_skb;
+	/* allocated rx buffer offset */
+	unsigned int rx_buf_offset;
+
+	/* size of allocated rx frag */
+	unsigned int rx_frag_size;
+
+	/* list of buffer given to hw for rx */
+	unsigned char **rx_buf;
 
 	/* used when rx skb allocation failed, so we defer rx queue
 	 * refill */
@@ -251,13 +257,12 @@ static inline void dmas_writel(struct bcm6368_enetsw *priv, u32 val,
 /*
  * refill rx queue
  */
-static int bcm6368_enetsw_refill_rx(struct net_device *dev)
+static int bcm6368_enetsw_refill_rx(struct net_device *dev, bool napi_mode)
 {
 	struct bcm6368_enetsw *priv = netdev_priv(dev);
 
 	while (priv->rx_desc_count < priv->rx_ring_size) {
 		struct bcm6368_enetsw_desc *desc;
-		struct sk_buff *skb;
 		dma_addr_t p;
 		int desc_idx;
 		u32 len_stat;
@@ -265,18 +270,32 @@ static int bcm6368_enetsw_refill_rx(struct net_device *dev)
 		desc_idx = priv->rx_dirty_desc;
 		desc = &priv->rx_desc_cpu[desc_idx];
 
-		if (!priv->rx_skb[desc_idx]) {
-			skb = netdev_alloc_skb(dev, priv->rx_skb_size);
-			if (!skb)
+		if (!priv->rx_buf[desc_idx]) {
+			unsigned char *buf;
+
+			/* buffers come from the per-cpu page frag cache,
+			 * which napi can use without disabling irqs */
+			if (likely(napi_mode))
+				buf = napi_alloc_frag(priv->rx_frag_size);
+			else
+				buf = netdev_alloc_frag(priv->rx_frag_size);
+			if (unlikely(!buf))
 				break;
-			priv->rx_skb[desc_idx] = skb;
-			p = dma_map_single(&priv->pdev->dev, skb->data,
-					   priv->rx_skb_size,
+
+			p = dma_map_single(&priv->pdev->dev,
+					   buf + priv->rx_buf_offset,
+					   priv->rx_buf_size,
 					   DMA_FROM_DEVICE);
+			if (unlikely(dma_mapping_error(&priv->pdev->dev, p))) {
+				skb_free_frag(buf);
+				break;
+			}
+
+			priv->rx_buf[desc_idx] = buf;
 			desc->address = p;
 		}
 
-		len_stat = priv->rx_skb_size << DMADESC_LENGTH_SHIFT;
+		len_stat = priv->rx_buf_size << DMADESC_LENGTH_SHIFT;
 		len_stat |= DMADESC_OWNER_MASK;
 		if (priv->rx_dirty_desc == priv->rx_ring_size - 1) {
 			len_stat |= DMADESC_WRAP_MASK;
@@ -313,7 +332,7 @@ static void bcm6368_enetsw_refill_rx_timer(struct timer_list *t)
 	struct net_device *dev = priv->net_dev;
 
 	spin_lock(&priv->rx_lock);
-	bcm6368_enetsw_refill_rx(dev);
+	bcm6368_enetsw_refill_rx(dev, false);
 	spin_unlock(&priv->rx_lock);
 }
 
@@ -324,8 +343,12 @@ static int bcm6368_enetsw_receive_queue(struct net_device *dev, int budget)
 {
 	struct bcm6368_enetsw *priv = netdev_priv(dev);
 	struct device *kdev = &priv->pdev->dev;
+	struct list_head rx_list;
+	struct sk_buff *skb;
 	int processed = 0;
 
+	INIT_LIST_HEAD(&rx_list);
+
 	/* don't scan ring further than number of refilled
 	 * descriptor */
 	if (budget > priv->rx_desc_count)
@@ -333,7 +356,7 @@ static int bcm6368_enetsw_receive_queue(struct net_device *dev, int budget)
 
 	do {
 		struct bcm6368_enetsw_desc *desc;
-		struct sk_buff *skb;
+		unsigned char *buf;
 		int desc_idx;
 		u32 len_stat;
 		unsigned int len;
@@ -365,17 +388,16 @@ static int bcm6368_enetsw_receive_queue(struct net_device *dev, int budget)
 		}
 
 		/* valid packet */
-		skb = priv->rx_skb[desc_idx];
+		buf = priv->rx_buf[desc_idx];
 		len = (len_stat & DMADESC_LENGTH_MASK)
 		      >> DMADESC_LENGTH_SHIFT;
 		/* don't include FCS */
 		len -= 4;
 
 		if (len < priv->copybreak) {
-			struct sk_buff *nskb;
-
-			nskb = napi_alloc_skb(&priv->napi, len);
-			if (!nskb) {
+			/* copy small packets, the buffer stays armed */
+			skb = napi_alloc_skb(&priv->napi, len);
+			if (unlikely(!skb)) {
 				/* forget packet, just rearm desc */
 				dev->stats.rx_dropped++;
 				continue;
@@ -383,56 +405,66 @@ static int bcm6368_enetsw_receive_queue(struct net_device *dev, int budget)
 
 			dma_sync_single_for_cpu(kdev, desc->address,
 						len, DMA_FROM_DEVICE);
-			memcpy(nskb->data, skb->data, len);
+			memcpy(skb->data, buf + priv->rx_buf_offset, len);
 			dma_sync_single_for_device(kdev, desc->address,
 						   len, DMA_FROM_DEVICE);
-			skb = nskb;
 		} else {
-			dma_unmap_single(&priv->pdev->dev, desc->address,
-					 priv->rx_skb_size, DMA_FROM_DEVICE);
-			priv->rx_skb[desc_idx] = NULL;
+			dma_unmap_single(kdev, desc->address,
+					 priv->rx_buf_size, DMA_FROM_DEVICE);
+			priv->rx_buf[desc_idx] = NULL;
+
+			skb = build_skb(buf, priv->rx_frag_size);
+			if (unlikely(!skb)) {
+				skb_free_frag(buf);
+				dev->stats.rx_dropped++;
+				continue;
+			}
+			skb_reserve(skb, priv->rx_buf_offset);
 		}
 
 		skb_put(skb, len);
 		skb->protocol = eth_type_trans(skb, dev);
 		dev->stats.rx_packets++;
 		dev->stats.rx_bytes += len;
-		netif_receive_skb(skb);
+		list_add_tail(&skb->list, &rx_list);
 	} while (--budget > 0);
 
+	/* hand the emptied descriptors back before the stack runs */
 	if (processed || !priv->rx_desc_count) {
-		bcm6368_enetsw_refill_rx(dev);
+		bcm6368_enetsw_refill_rx(dev, true);
 
 		/* kick rx dma */
 		dmac_writel(priv, priv->dma_chan_en_mask,
 			    DMAC_CHANCFG_REG, priv->rx_chan);
 	}
 
+	netif_receive_skb_list(&rx_list);
+
 	return processed;
 }
 
 /*
  * try to or force reclaim of transmitted buffers
  */
-static int bcm6368_enetsw_tx_reclaim(struct net_device *dev, int force)
+static int bcm6368_enetsw_tx_reclaim(struct net_device *dev, int force,
+				     int budget)
 {
 	struct bcm6368_enetsw *priv = netdev_priv(dev);
+	unsigned int bytes = 0;
 	int released = 0;
 
+	/* We run in a bh and fight against start_xmit, which
+	 * is called with bh disabled */
+	spin_lock(&priv->tx_lock);
+
 	while (priv->tx_desc_count < priv->tx_ring_size) {
 		struct bcm6368_enetsw_desc *desc;
 		struct sk_buff *skb;
 
-		/* We run in a bh and fight against start_xmit, which
-		 * is called with bh disabled */
-		spin_lock(&priv->tx_lock);
-
 		desc = &priv->tx_desc_cpu[priv->tx_dirty_desc];
 
-		if (!force && (desc->len_stat & DMADESC_OWNER_MASK)) {
-			spin_unlock(&priv->tx_lock);
+		if (!force && (desc->len_stat & DMADESC_OWNER_MASK))
 			break;
-		}
 
 		/* ensure other field of the descriptor were not read
 		 * before we checked ownership */
@@ -448,18 +480,21 @@ static int bcm6368_enetsw_tx_reclaim(struct net_device *dev, int force)
 			priv->tx_dirty_desc = 0;
 		priv->tx_desc_count++;
 
-		spin_unlock(&priv->tx_lock);
-
 		if (desc->len_stat & DMADESC_UNDER_MASK)
 			dev->stats.tx_errors++;
 
-		dev_kfree_skb(skb);
+		bytes += skb->len;
+		napi_consume_skb(skb, budget);
 		released++;
 	}
 
+	netdev_completed_queue(dev, released, bytes);
+
 	if (netif_queue_stopped(dev) && released)
 		netif_wake_queue(dev);
 
+	spin_unlock(&priv->tx_lock);
+
 	return released;
 }
 
@@ -479,7 +514,7 @@ static int bcm6368_enetsw_poll(struct napi_struct *napi, int budget)
 			 DMAC_IR_REG, priv->tx_chan);
 
 	/* reclaim sent skb */
-	bcm6368_enetsw_tx_reclaim(dev, 0);
+	bcm6368_enetsw_tx_reclaim(dev, 0, budget);
 
 	spin_lock(&priv->rx_lock);
 	rx_work_done = bcm6368_enetsw_receive_queue(dev, budget);
@@ -554,7 +589,13 @@ bcm6368_enetsw_start_xmit(struct sk_buff *skb, struct net_device *dev)
 
 			nskb = skb_copy_expand(skb, 0, needed, GFP_ATOMIC);
 			if (!nskb) {
-				ret = NETDEV_TX_BUSY;
+				/* drop it, and send out what earlier calls
+				 * left for us to kick */
+				dev_kfree_skb(skb);
+				dev->stats.tx_dropped++;
+				dmac_writel(priv, priv->dma_chan_en_mask,
+					    DMAC_CHANCFG_REG, priv->tx_chan);
+				ret = NETDEV_TX_OK;
 				goto out_unlock;
 			}
 
@@ -589,9 +630,12 @@ bcm6368_enetsw_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	desc->len_stat = len_stat;
 	wmb();
 
-	/* kick tx dma */
-	dmac_writel(priv, priv->dma_chan_en_mask, DMAC_CHANCFG_REG,
-		    priv->tx_chan);
+	/* kick tx dma once for a batch of packets, or when the ring
+	 * is about to stop */
+	if (__netdev_sent_queue(dev, skb->len, netdev_xmit_more()) ||
+	    !priv->tx_desc_count)
+		dmac_writel(priv, priv->dma_chan_en_mask, DMAC_CHANCFG_REG,
+			    priv->tx_chan);
 
 	/* stop queue if no more desc available */
 	if (!priv->tx_desc_count)
@@ -690,10 +734,10 @@ static int bcm6368_enetsw_open(struct net_device *dev)
 	priv->tx_curr_desc = 0;
 	spin_lock_init(&priv->tx_lock);
 
-	/* init & fill rx ring with skbs */
-	priv->rx_skb = kzalloc(sizeof(struct sk_buff *) * priv->rx_ring_size,
+	/* init & fill rx ring with buffers */
+	priv->rx_buf = kcalloc(priv->rx_ring_size, sizeof(unsigned char *),
 			       GFP_KERNEL);
-	if (!priv->rx_skb) {
+	if (!priv->rx_buf) {
 		dev_err(kdev, "cannot allocate rx skb queue\n");
 		ret = -ENOMEM;
 		goto out_free_tx_skb;
@@ -707,7 +751,7 @@ static int bcm6368_enetsw_open(struct net_device *dev)
 	dma_writel(priv, DMA_BUFALLOC_FORCE_MASK | 0,
 		   DMA_BUFALLOC_REG(priv->rx_chan));
 
-	if (bcm6368_enetsw_refill_rx(dev)) {
+	if (bcm6368_enetsw_refill_rx(dev, false)) {
 		dev_err(kdev, "cannot allocate rx skb queue\n");
 		ret = -ENOMEM;
 		goto out;
@@ -762,6 +806,7 @@ static int bcm6368_enetsw_open(struct net_device *dev)
 		    DMAC_IRMASK_REG, priv->tx_chan);
 
 	netif_carrier_on(dev);
+	netdev_reset_queue(dev);
 	netif_start_queue(dev);
 
 	return 0;
@@ -770,15 +815,15 @@ out:
 	for (i = 0; i < priv->rx_ring_size; i++) {
 		struct bcm6368_enetsw_desc *desc;
 
-		if (!priv->rx_skb[i])
+		if (!priv->rx_buf[i])
 			continue;
 
 		desc = &priv->rx_desc_cpu[i];
-		dma_unmap_single(kdev, desc->address, priv->rx_skb_size,
+		dma_unmap_single(kdev, desc->address, priv->rx_buf_size,
 				 DMA_FROM_DEVICE);
-		kfree_skb(priv->rx_skb[i]);
+		skb_free_frag(priv->rx_buf[i]);
 	}
-	kfree(priv->rx_skb);
+	kfree(priv->rx_buf);
 
 out_free_tx_skb:
 	kfree(priv->tx_skb);
@@ -821,24 +866,24 @@ static int bcm6368_enetsw_stop(struct net_device *dev)
 	bcm6368_enetsw_disable_dma(priv, priv->rx_chan);
 
 	/* force reclaim of all tx buffers */
-	bcm6368_enetsw_tx_reclaim(dev, 1);
+	bcm6368_enetsw_tx_reclaim(dev, 1, 0);
 
-	/* free the rx skb ring */
+	/* free the rx buffer ring */
 	for (i = 0; i < priv->rx_ring_size; i++) {
 		struct bcm6368_enetsw_desc *desc;
 
-		if (!priv->rx_skb[i])
+		if (!priv->rx_buf[i])
 			continue;
 
 		desc = &priv->rx_desc_cpu[i];
-		dma_unmap_single_attrs(kdev, desc->address, priv->rx_skb_size,
+		dma_unmap_single_attrs(kdev, desc->address, priv->rx_buf_size,
 				       DMA_FROM_DEVICE,
 				       DMA_ATTR_SKIP_CPU_SYNC);
-		kfree_skb(priv->rx_skb[i]);
+		skb_free_frag(priv->rx_buf[i]);
 	}
 
 	/* free remaining allocated memory */
-	kfree(priv->rx_skb);
+	kfree(priv->rx_buf);
 	kfree(priv->tx_skb);
 	dma_free_coherent(kdev, priv->rx_desc_alloc_size,
 			  priv->rx_desc_cpu, priv->rx_desc_dma);
@@ -962,8 +1007,12 @@ static int bcm6368_enetsw_probe(struct platform_device *pdev)
 		dev_info(dev, "random mac %pM\n", ndev->dev_addr);
 	}
 
-	priv->rx_skb_size = ALIGN(ndev->mtu + ENETSW_MTU_OVERHEAD,
+	priv->rx_buf_size = ALIGN(ndev->mtu + ENETSW_MTU_OVERHEAD,
 				  priv->dma_maxburst * 4);
+	priv->rx_buf_offset = NET_SKB_PAD;
+	priv->rx_frag_size = SKB_DATA_ALIGN(priv->rx_buf_offset +
+					    priv->rx_buf_size) +
+			     SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
 
 	priv->num_clocks = of_clk_get_parent_count(node);
 	if (priv->num_clocks) {
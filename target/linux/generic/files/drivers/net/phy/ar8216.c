@@ -36,6 +36,8 @@
 #include <linux/ar8216_platform.h>
 #include <linux/workqueue.h>
 #include <linux/version.h>
+#include <linux/ctype.h>
+#include <linux/math64.h>
 
 #include "ar8216.h"
 
@@ -458,6 +460,65 @@ ar8xxx_mib_fetch_port_stat(struct ar8xxx_priv *priv, int port, bool flush)
 	}
 }
 
+static u64
+ar8xxx_mib_sum(const u64 *mib_stats, u64 mask)
+{
+	u64 sum = 0;
+	int i;
+
+	for (i = 0; mask; i++, mask >>= 1)
+		if (mask & 1)
+			sum += mib_stats[i];
+
+	return sum;
+}
+
+/* record the accumulated counters of all ports in the history ring */
+static void
+ar8xxx_mib_record(struct ar8xxx_priv *priv)
+{
+	const struct ar8xxx_chip *chip = priv->chip;
+	unsigned long now = jiffies;
+	int i;
+
+	lockdep_assert_held(&priv->mib_lock);
+
+	for (i = 0; i < priv->dev.ports; i++) {
+		u64 *mib_stats = &priv->mib_stats[i * chip->num_mibs];
+		struct ar8xxx_mib_sample *s;
+
+		s = &priv->mib_hist[i * AR8XXX_MIB_HIST_LEN + priv->mib_hist_head];
+		s->time = now;
+		s->rx_bytes = mib_stats[chip->mib_rxb_id];
+		s->tx_bytes = mib_stats[chip->mib_txb_id];
+		s->rx_pkts = ar8xxx_mib_sum(mib_stats, priv->mib_rx_pkt_mask);
+		s->tx_pkts = ar8xxx_mib_sum(mib_stats, priv->mib_tx_pkt_mask);
+	}
+
+	priv->mib_hist_head = (priv->mib_hist_head + 1) % AR8XXX_MIB_HIST_LEN;
+	if (priv->mib_hist_count < AR8XXX_MIB_HIST_LEN)
+		priv->mib_hist_count++;
+}
+
+/* n-th newest sample of a port, n = 0 is the latest one */
+static struct ar8xxx_mib_sample *
+ar8xxx_mib_sample(struct ar8xxx_priv *priv, int port, unsigned int n)
+{
+	unsigned int idx;
+
+	idx = (priv->mib_hist_head + AR8XXX_MIB_HIST_LEN - 1 - n) %
+	      AR8XXX_MIB_HIST_LEN;
+
+	return &priv->mib_hist[port * AR8XXX_MIB_HIST_LEN + idx];
+}
+
+/* counters go back to zero when the MIBs are reset */
+static inline u64
+ar8xxx_mib_delta(u64 cur, u64 prev)
+{
+	return cur >= prev ? cur - prev : cur;
+}
+
 static void
 ar8216_read_port_link(struct ar8xxx_priv *priv, int port,
 		      struct switch_port_link *link)
@@ -1756,6 +1817,103 @@ unlock:
 	return ret;
 }
 
+static int
+ar8xxx_mib_hist_check(struct ar8xxx_priv *priv, struct switch_val *val)
+{
+	if (!ar8xxx_has_mib_counters(priv) || !priv->mib_poll_interval ||
+	    !(priv->chip->mib_rxb_id || priv->chip->mib_txb_id))
+		return -EOPNOTSUPP;
+
+	if (val->port_vlan >= priv->dev.ports)
+		return -EINVAL;
+
+	return 0;
+}
+
+int
+ar8xxx_sw_get_port_mib_rate(struct switch_dev *dev,
+			    const struct switch_attr *attr,
+			    struct switch_val *val)
+{
+	struct ar8xxx_priv *priv = swdev_to_ar8xxx(dev);
+	struct ar8xxx_mib_sample *cur, *prev;
+	u64 rx_bps = 0, tx_bps = 0, rx_pps = 0, tx_pps = 0;
+	unsigned int ms;
+	char *buf = priv->buf;
+	int ret;
+
+	ret = ar8xxx_mib_hist_check(priv, val);
+	if (ret)
+		return ret;
+
+	mutex_lock(&priv->mib_lock);
+	if (priv->mib_hist_count >= 2) {
+		cur = ar8xxx_mib_sample(priv, val->port_vlan, 0);
+		prev = ar8xxx_mib_sample(priv, val->port_vlan, 1);
+		ms = jiffies_to_msecs(cur->time - prev->time);
+		if (ms) {
+			rx_bps = div_u64(ar8xxx_mib_delta(cur->rx_bytes,
+					 prev->rx_bytes) * 8 * MSEC_PER_SEC, ms);
+			tx_bps = div_u64(ar8xxx_mib_delta(cur->tx_bytes,
+					 prev->tx_bytes) * 8 * MSEC_PER_SEC, ms);
+			rx_pps = div_u64(ar8xxx_mib_delta(cur->rx_pkts,
+					 prev->rx_pkts) * MSEC_PER_SEC, ms);
+			tx_pps = div_u64(ar8xxx_mib_delta(cur->tx_pkts,
+					 prev->tx_pkts) * MSEC_PER_SEC, ms);
+		}
+	}
+	mutex_unlock(&priv->mib_lock);
+
+	val->len = snprintf(buf, sizeof(priv->buf),
+			    "rx_bps=%llu\ntx_bps=%llu\nrx_pps=%llu\ntx_pps=%llu\n",
+			    rx_bps, tx_bps, rx_pps, tx_pps);
+	val->value.s = buf;
+
+	return 0;
+}
+
+int
+ar8xxx_sw_get_port_mib_history(struct switch_dev *dev,
+			       const struct switch_attr *attr,
+			       struct switch_val *val)
+{
+	struct ar8xxx_priv *priv = swdev_to_ar8xxx(dev);
+	char *buf = priv->mib_hist_buf;
+	int size = sizeof(priv->mib_hist_buf);
+	unsigned long now = jiffies;
+	int i, ret, len = 0;
+
+	ret = ar8xxx_mib_hist_check(priv, val);
+	if (ret)
+		return ret;
+
+	len += scnprintf(buf + len, size - len,
+			 "# age_ms interval_ms rx_bytes tx_bytes rx_pkts tx_pkts\n");
+
+	/* one line per poll interval, oldest first, counter deltas */
+	mutex_lock(&priv->mib_lock);
+	for (i = priv->mib_hist_count - 1; i > 0; i--) {
+		struct ar8xxx_mib_sample *cur, *prev;
+
+		cur = ar8xxx_mib_sample(priv, val->port_vlan, i - 1);
+		prev = ar8xxx_mib_sample(priv, val->port_vlan, i);
+		len += scnprintf(buf + len, size - len,
+				 "%u %u %llu %llu %llu %llu\n",
+				 jiffies_to_msecs(now - cur->time),
+				 jiffies_to_msecs(cur->time - prev->time),
+				 ar8xxx_mib_delta(cur->rx_bytes, prev->rx_bytes),
+				 ar8xxx_mib_delta(cur->tx_bytes, prev->tx_bytes),
+				 ar8xxx_mib_delta(cur->rx_pkts, prev->rx_pkts),
+				 ar8xxx_mib_delta(cur->tx_pkts, prev->tx_pkts));
+	}
+	mutex_unlock(&priv->mib_lock);
+
+	val->value.s = buf;
+	val->len = len;
+
+	return 0;
+}
+
 int
 ar8xxx_sw_set_arl_age_time(struct switch_dev *dev, const struct switch_attr *attr,
 			   struct switch_val *val)
@@ -2031,6 +2189,20 @@ const struct switch_attr ar8xxx_sw_attr_port[] = {
 		.description = "Flush port's ARL table entries",
 		.set = ar8xxx_sw_set_flush_port_arl_table,
 	},
+	{
+		.type = SWITCH_TYPE_STRING,
+		.name = "mib_rate",
+		.description = "Get port's bit and packet rates of the last MIB poll",
+		.set = NULL,
+		.get = ar8xxx_sw_get_port_mib_rate,
+	},
+	{
+		.type = SWITCH_TYPE_STRING,
+		.name = "mib_history",
+		.description = "Get port's MIB counter deltas per poll interval",
+		.set = NULL,
+		.get = ar8xxx_sw_get_port_mib_history,
+	},
 };
 
 const struct switch_attr ar8xxx_sw_attr_vlan[1] = {
@@ -2312,29 +2484,74 @@ ar8xxx_mib_work_func(struct work_struct *work)
 	for (i = 0; i < priv->dev.ports; i++)
 		ar8xxx_mib_fetch_port_stat(priv, i, false);
 
+	ar8xxx_mib_record(priv);
+
 next_attempt:
 	mutex_unlock(&priv->mib_lock);
 	schedule_delayed_work(&priv->mib_work,
 			      msecs_to_jiffies(priv->mib_poll_interval));
 }
 
+/*
+ * Packets are not counted as such, but the frame size histogram MIBs
+ * (Rx64Byte ... RxMaxByte) add up to the number of good frames.
+ */
+static bool
+ar8xxx_mib_is_size_bucket(const char *name)
+{
+	const char *p = name + 2;
+
+	if (!strcmp(p, "MaxByte"))
+		return true;
+
+	if (!isdigit(*p))
+		return false;
+
+	while (isdigit(*p))
+		p++;
+
+	return !strcmp(p, "Byte");
+}
+
 static int
 ar8xxx_mib_init(struct ar8xxx_priv *priv)
 {
+	const struct ar8xxx_chip *chip = priv->chip;
 	unsigned int len;
+	int i;
 
 	if (!ar8xxx_has_mib_counters(priv))
 		return 0;
 
-	BUG_ON(!priv->chip->mib_decs || !priv->chip->num_mibs);
+	BUG_ON(!chip->mib_decs || !chip->num_mibs || chip->num_mibs > 64);
 
-	len = priv->dev.ports * priv->chip->num_mibs *
+	len = priv->dev.ports * chip->num_mibs *
 	      sizeof(*priv->mib_stats);
 	priv->mib_stats = kzalloc(len, GFP_KERNEL);
 
 	if (!priv->mib_stats)
 		return -ENOMEM;
 
+	priv->mib_hist = kcalloc(priv->dev.ports * AR8XXX_MIB_HIST_LEN,
+				 sizeof(*priv->mib_hist), GFP_KERNEL);
+	if (!priv->mib_hist) {
+		kfree(priv->mib_stats);
+		priv->mib_stats = NULL;
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < chip->num_mibs; i++) {
+		const char *name = chip->mib_decs[i].name;
+
+		if (!ar8xxx_mib_is_size_bucket(name))
+			continue;
+
+		if (!strncmp(name, "Rx", 2))
+			priv->mib_rx_pkt_mask |= BIT_ULL(i);
+		else if (!strncmp(name, "Tx", 2))
+			priv->mib_tx_pkt_mask |= BIT_ULL(i);
+	}
+
 	return 0;
 }
 
@@ -2381,6 +2598,7 @@ ar8xxx_free(struct ar8xxx_priv *priv)
 
 	kfree(priv->chip_data);
 	kfree(priv->mib_stats);
+	kfree(priv->mib_hist);
 	kfree(priv);
 }
 
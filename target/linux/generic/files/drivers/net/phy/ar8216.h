@@ -420,6 +420,17 @@ struct arl_entry {
 
 struct ar8xxx_priv;
 
+/* number of MIB samples kept per port, one per mib_poll_interval */
+#define AR8XXX_MIB_HIST_LEN	64
+
+struct ar8xxx_mib_sample {
+	unsigned long time;	/* jiffies */
+	u64 rx_bytes;
+	u64 tx_bytes;
+	u64 rx_pkts;
+	u64 tx_pkts;
+};
+
 struct ar8xxx_mib_desc {
 	unsigned int size;
 	unsigned int offset;
@@ -501,6 +512,12 @@ struct ar8xxx_priv {
 	u64 *mib_stats;
 	u32 mib_poll_interval;
 	u8 mib_type;
+	u64 mib_rx_pkt_mask;	/* MIBs summed up to get packet counts */
+	u64 mib_tx_pkt_mask;
+	struct ar8xxx_mib_sample *mib_hist;	/* AR8XXX_MIB_HIST_LEN per port */
+	unsigned int mib_hist_head;	/* next sample slot, same for all ports */
+	unsigned int mib_hist_count;
+	char mib_hist_buf[AR8XXX_MIB_HIST_LEN * 64 + 64];
 
 	struct list_head list;
 	unsigned int use_count;
@@ -623,6 +640,14 @@ ar8xxx_sw_get_port_mib(struct switch_dev *dev,
                        const struct switch_attr *attr,
                        struct switch_val *val);
 int
+ar8xxx_sw_get_port_mib_rate(struct switch_dev *dev,
+			    const struct switch_attr *attr,
+			    struct switch_val *val);
+int
+ar8xxx_sw_get_port_mib_history(struct switch_dev *dev,
+			       const struct switch_attr *attr,
+			       struct switch_val *val);
+int
 ar8xxx_sw_get_arl_age_time(struct switch_dev *dev,
 			   const struct switch_attr *attr,
 			   struct switch_val *val);
@@ -1449,6 +1449,20 @@ static const struct switch_attr ar8327_sw_attr_port[] = {
 		.get = ar8327_sw_get_port_vlan_prio,
 		.max = 7,
 	},
+	{
+		.type = SWITCH_TYPE_STRING,
+		.name = "mib_rate",
+		.description = "Get port's bit and packet rates of the last MIB poll",
+		.set = NULL,
+		.get = ar8xxx_sw_get_port_mib_rate,
+	},
+	{
+		.type = SWITCH_TYPE_STRING,
+		.name = "mib_history",
+		.description = "Get port's MIB counter deltas per poll interval",
+		.set = NULL,
+		.get = ar8xxx_sw_get_port_mib_history,
+	},
 };
 
 static const struct switch_dev_ops ar8327_sw_ops = {
@@ -22,6 +22,7 @@
 #include <linux/export.h>
 #include <linux/gpio.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/switch.h>
 #include <linux/phy.h>
@@ -425,45 +426,68 @@ static void b53_enable_mib(struct b53_device *dev)
 
 static int b53_apply(struct b53_device *dev)
 {
+	bool full = !dev->hw_valid;
 	int i;
 
-	/* clear all vlan entries */
-	if (is5325(dev) || is5365(dev)) {
-		for (i = 1; i < dev->sw_dev.vlans; i++)
-			b53_set_vlan_entry(dev, i, 0, 0);
-	} else {
-		b53_do_vlan_op(dev, VTA_CMD_CLEAR);
+	/*
+	 * Only rewrite what differs from the last applied configuration,
+	 * unless the switch has been reset since and its state is unknown.
+	 */
+	if (full) {
+		/* clear all vlan entries */
+		if (is5325(dev) || is5365(dev)) {
+			for (i = 1; i < dev->sw_dev.vlans; i++)
+				b53_set_vlan_entry(dev, i, 0, 0);
+		} else {
+			b53_do_vlan_op(dev, VTA_CMD_CLEAR);
+		}
+
+		memset(dev->hw_vlans, 0,
+		       sizeof(*dev->hw_vlans) * dev->sw_dev.vlans);
 	}
 
-	b53_enable_vlan(dev, dev->enable_vlan);
+	if (full || dev->hw_enable_vlan != dev->enable_vlan ||
+	    dev->hw_allow_vid_4095 != dev->allow_vid_4095)
+		b53_enable_vlan(dev, dev->enable_vlan);
 
-	/* fill VLAN table */
-	if (dev->enable_vlan) {
-		for (i = 0; i < dev->sw_dev.vlans; i++) {
-			struct b53_vlan *vlan = &dev->vlans[i];
+	/* sync VLAN table, which stays empty with vlans disabled */
+	for (i = 0; i < dev->sw_dev.vlans; i++) {
+		struct b53_vlan vlan = { 0 };
+		struct b53_vlan *hw_vlan = &dev->hw_vlans[i];
 
-			if (!vlan->members)
-				continue;
+		if (dev->enable_vlan)
+			vlan = dev->vlans[i];
 
-			b53_set_vlan_entry(dev, i, vlan->members, vlan->untag);
-		}
+		if (vlan.members == hw_vlan->members &&
+		    vlan.untag == hw_vlan->untag)
+			continue;
 
-		b53_for_each_port(dev, i)
-			b53_write16(dev, B53_VLAN_PAGE,
-				    B53_VLAN_PORT_DEF_TAG(i),
-				    dev->ports[i].pvid);
-	} else {
-		b53_for_each_port(dev, i)
-			b53_write16(dev, B53_VLAN_PAGE,
-				    B53_VLAN_PORT_DEF_TAG(i), 1);
+		b53_set_vlan_entry(dev, i, vlan.members, vlan.untag);
+		*hw_vlan = vlan;
+	}
 
+	b53_for_each_port(dev, i) {
+		u16 pvid = dev->enable_vlan ? dev->ports[i].pvid : 1;
+
+		if (!full && dev->hw_ports[i].pvid == pvid)
+			continue;
+
+		b53_write16(dev, B53_VLAN_PAGE, B53_VLAN_PORT_DEF_TAG(i), pvid);
+		dev->hw_ports[i].pvid = pvid;
 	}
 
-	b53_enable_ports(dev);
+	if (full || dev->hw_enable_vlan != dev->enable_vlan)
+		b53_enable_ports(dev);
 
-	if (!is5325(dev) && !is5365(dev))
+	if (!is5325(dev) && !is5365(dev) &&
+	    (full || dev->hw_enable_jumbo != dev->enable_jumbo))
 		b53_set_jumbo(dev, dev->enable_jumbo, 1);
 
+	dev->hw_enable_vlan = dev->enable_vlan;
+	dev->hw_enable_jumbo = dev->enable_jumbo;
+	dev->hw_allow_vid_4095 = dev->allow_vid_4095;
+	dev->hw_valid = 1;
+
 	return 0;
 }
 
@@ -653,11 +677,15 @@ static int b53_switch_reset(struct b53_device *dev)
 	int ret = 0;
 	u8 mgmt;
 
+	/* force a full rewrite on the next apply */
+	dev->hw_valid = 0;
+
 	b53_switch_reset_gpio(dev);
 
 	if (is539x(dev)) {
 		b53_write8(dev, B53_CTRL_PAGE, B53_SOFTRESET, 0x83);
 		b53_write8(dev, B53_CTRL_PAGE, B53_SOFTRESET, 0x00);
+		dev->current_page = 0xff;
 	}
 
 	b53_read8(dev, B53_CTRL_PAGE, B53_SWITCH_MODE, &mgmt);
@@ -983,6 +1011,7 @@ static int b53_global_reset_switch(struct switch_dev *dev)
 static int b53_global_apply_config(struct switch_dev *dev)
 {
 	struct b53_device *priv = sw_to_b53(dev);
+	ktime_t start = ktime_get();
 
 	/* disable switching */
 	b53_set_forwarding(priv, 0);
@@ -992,6 +1021,9 @@ static int b53_global_apply_config(struct switch_dev *dev)
 	/* enable switching */
 	b53_set_forwarding(priv, 1);
 
+	dev_dbg(priv->dev, "applied config in %lld us\n",
+		ktime_us_delta(ktime_get(), start));
+
 	return 0;
 }
 
@@ -1602,6 +1634,18 @@ static int b53_switch_init(struct b53_device *dev)
 	if (!dev->vlans)
 		return -ENOMEM;
 
+	dev->hw_ports = devm_kzalloc(dev->dev,
+				     sizeof(struct b53_port) * sw_dev->ports,
+				     GFP_KERNEL);
+	if (!dev->hw_ports)
+		return -ENOMEM;
+
+	dev->hw_vlans = devm_kzalloc(dev->dev,
+				     sizeof(struct b53_vlan) * sw_dev->vlans,
+				     GFP_KERNEL);
+	if (!dev->hw_vlans)
+		return -ENOMEM;
+
 	dev->buf = devm_kzalloc(dev->dev, B53_BUF_SIZE, GFP_KERNEL);
 	if (!dev->buf)
 		return -ENOMEM;
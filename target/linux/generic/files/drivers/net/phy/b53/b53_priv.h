@@ -101,6 +101,15 @@ struct b53_device {
 	struct b53_port *ports;
 	struct b53_vlan *vlans;
 
+	/* last configuration written to the hardware by b53_apply() */
+	unsigned hw_valid:1;
+	unsigned hw_enable_vlan:1;
+	unsigned hw_enable_jumbo:1;
+	unsigned hw_allow_vid_4095:1;
+
+	struct b53_port *hw_ports;
+	struct b53_vlan *hw_vlans;
+
 	char *buf;
 };
 
@@ -84,14 +84,21 @@ static inline int b53_spi_set_page(struct spi_device *spi, u8 page)
 	return spi_write(spi, txbuf, sizeof(txbuf));
 }
 
-static inline int b53_prepare_reg_access(struct spi_device *spi, u8 page)
+static inline int b53_prepare_reg_access(struct b53_device *dev, u8 page)
 {
+	struct spi_device *spi = dev->priv;
 	int ret = b53_spi_clear_status(spi);
 
 	if (ret)
 		return ret;
 
-	return b53_spi_set_page(spi, page);
+	if (dev->current_page == page)
+		return 0;
+
+	ret = b53_spi_set_page(spi, page);
+	dev->current_page = ret ? 0xff : page;
+
+	return ret;
 }
 
 static int b53_spi_prepare_reg_read(struct spi_device *spi, u8 reg)
@@ -127,7 +134,7 @@ static int b53_spi_read(struct b53_device *dev, u8 page, u8 reg, u8 *data,
 	struct spi_device *spi = dev->priv;
 	int ret;
 
-	ret = b53_prepare_reg_access(spi, page);
+	ret = b53_prepare_reg_access(dev, page);
 	if (ret)
 		return ret;
 
@@ -191,7 +198,7 @@ static int b53_spi_write8(struct b53_device *dev, u8 page, u8 reg, u8 value)
 	int ret;
 	u8 txbuf[3];
 
-	ret = b53_prepare_reg_access(spi, page);
+	ret = b53_prepare_reg_access(dev, page);
 	if (ret)
 		return ret;
 
@@ -208,7 +215,7 @@ static int b53_spi_write16(struct b53_device *dev, u8 page, u8 reg, u16 value)
 	int ret;
 	u8 txbuf[4];
 
-	ret = b53_prepare_reg_access(spi, page);
+	ret = b53_prepare_reg_access(dev, page);
 	if (ret)
 		return ret;
 
@@ -225,7 +232,7 @@ static int b53_spi_write32(struct b53_device *dev, u8 page, u8 reg, u32 value)
 	int ret;
 	u8 txbuf[6];
 
-	ret = b53_prepare_reg_access(spi, page);
+	ret = b53_prepare_reg_access(dev, page);
 	if (ret)
 		return ret;
 
@@ -242,7 +249,7 @@ static int b53_spi_write48(struct b53_device *dev, u8 page, u8 reg, u64 value)
 	int ret;
 	u8 txbuf[10];
 
-	ret = b53_prepare_reg_access(spi, page);
+	ret = b53_prepare_reg_access(dev, page);
 	if (ret)
 		return ret;
 
@@ -259,7 +266,7 @@ static int b53_spi_write64(struct b53_device *dev, u8 page, u8 reg, u64 value)
 	int ret;
 	u8 txbuf[10];
 
-	ret = b53_prepare_reg_access(spi, page);
+	ret = b53_prepare_reg_access(dev, page);
 	if (ret)
 		return ret;
 
@@ -292,6 +299,9 @@ static int b53_spi_probe(struct spi_device *spi)
 	if (!dev)
 		return -ENOMEM;
 
+	/* we don't use page 0xff, so force a page set */
+	dev->current_page = 0xff;
+
 	if (spi->dev.platform_data)
 		dev->pdata = spi->dev.platform_data;
 
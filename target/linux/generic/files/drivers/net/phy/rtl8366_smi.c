@@ -13,7 +13,9 @@
 #include <linux/device.h>
 #include <linux/delay.h>
 #include <linux/gpio.h>
-#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/ktime.h>
 #include <linux/skbuff.h>
 #include <linux/of.h>
 #include <linux/of_platform.h>
@@ -52,19 +54,19 @@ static void rtl8366_smi_start(struct rtl8366_smi *smi)
 	rtl8366_smi_clk_delay(smi);
 
 	/* CLK 1: 0 -> 1, 1 -> 0 */
-	gpio_set_value(sck, 1);
+	gpio_set_value_cansleep(sck, 1);
 	rtl8366_smi_clk_delay(smi);
-	gpio_set_value(sck, 0);
+	gpio_set_value_cansleep(sck, 0);
 	rtl8366_smi_clk_delay(smi);
 
 	/* CLK 2: */
-	gpio_set_value(sck, 1);
+	gpio_set_value_cansleep(sck, 1);
 	rtl8366_smi_clk_delay(smi);
-	gpio_set_value(sda, 0);
+	gpio_set_value_cansleep(sda, 0);
 	rtl8366_smi_clk_delay(smi);
-	gpio_set_value(sck, 0);
+	gpio_set_value_cansleep(sck, 0);
 	rtl8366_smi_clk_delay(smi);
-	gpio_set_value(sda, 1);
+	gpio_set_value_cansleep(sda, 1);
 }
 
 static void rtl8366_smi_stop(struct rtl8366_smi *smi)
@@ -73,22 +75,22 @@ static void rtl8366_smi_stop(struct rtl8366_smi *smi)
 	unsigned int sck = smi->gpio_sck;
 
 	rtl8366_smi_clk_delay(smi);
-	gpio_set_value(sda, 0);
-	gpio_set_value(sck, 1);
+	gpio_set_value_cansleep(sda, 0);
+	gpio_set_value_cansleep(sck, 1);
 	rtl8366_smi_clk_delay(smi);
-	gpio_set_value(sda, 1);
+	gpio_set_value_cansleep(sda, 1);
 	rtl8366_smi_clk_delay(smi);
-	gpio_set_value(sck, 1);
+	gpio_set_value_cansleep(sck, 1);
 	rtl8366_smi_clk_delay(smi);
-	gpio_set_value(sck, 0);
+	gpio_set_value_cansleep(sck, 0);
 	rtl8366_smi_clk_delay(smi);
-	gpio_set_value(sck, 1);
+	gpio_set_value_cansleep(sck, 1);
 
 	/* add a click */
 	rtl8366_smi_clk_delay(smi);
-	gpio_set_value(sck, 0);
+	gpio_set_value_cansleep(sck, 0);
 	rtl8366_smi_clk_delay(smi);
-	gpio_set_value(sck, 1);
+	gpio_set_value_cansleep(sck, 1);
 
 	/* set GPIO pins to input mode */
 	gpio_direction_input(sda);
@@ -104,13 +106,13 @@ static void rtl8366_smi_write_bits(struct rtl8366_smi *smi, u32 data, u32 len)
 		rtl8366_smi_clk_delay(smi);
 
 		/* prepare data */
-		gpio_set_value(sda, !!(data & ( 1 << (len - 1))));
+		gpio_set_value_cansleep(sda, !!(data & ( 1 << (len - 1))));
 		rtl8366_smi_clk_delay(smi);
 
 		/* clocking */
-		gpio_set_value(sck, 1);
+		gpio_set_value_cansleep(sck, 1);
 		rtl8366_smi_clk_delay(smi);
-		gpio_set_value(sck, 0);
+		gpio_set_value_cansleep(sck, 0);
 	}
 }
 
@@ -127,10 +129,10 @@ static void rtl8366_smi_read_bits(struct rtl8366_smi *smi, u32 len, u32 *data)
 		rtl8366_smi_clk_delay(smi);
 
 		/* clocking */
-		gpio_set_value(sck, 1);
+		gpio_set_value_cansleep(sck, 1);
 		rtl8366_smi_clk_delay(smi);
-		u = !!gpio_get_value(sda);
-		gpio_set_value(sck, 0);
+		u = !!gpio_get_value_cansleep(sda);
+		gpio_set_value_cansleep(sck, 0);
 
 		*data |= (u << (len - 1));
 	}
@@ -201,13 +203,10 @@ static int rtl8366_smi_read_byte1(struct rtl8366_smi *smi, u8 *data)
 
 static int __rtl8366_smi_read_reg(struct rtl8366_smi *smi, u32 addr, u32 *data)
 {
-	unsigned long flags;
 	u8 lo = 0;
 	u8 hi = 0;
 	int ret;
 
-	spin_lock_irqsave(&smi->lock, flags);
-
 	rtl8366_smi_start(smi);
 
 	/* send READ command */
@@ -236,7 +235,6 @@ static int __rtl8366_smi_read_reg(struct rtl8366_smi *smi, u32 addr, u32 *data)
 
  out:
 	rtl8366_smi_stop(smi);
-	spin_unlock_irqrestore(&smi->lock, flags);
 
 	return ret;
 }
@@ -328,23 +326,93 @@ static int __rtl8366_mdio_write_reg(struct rtl8366_smi *smi, u32 addr, u32 data)
 	return 0;
 }
 
-int rtl8366_smi_read_reg(struct rtl8366_smi *smi, u32 addr, u32 *data)
+#ifdef CONFIG_RTL8366_SMI_DEBUG_FS
+static inline u64 rtl8366_smi_stats_start(void)
+{
+	return ktime_get_ns();
+}
+
+static void rtl8366_smi_stats_account(struct rtl8366_smi *smi, int dir,
+				      u64 start)
 {
+	struct rtl8366_smi_stats *stats = &smi->dbg_stats[dir];
+	u64 ns = ktime_get_ns() - start;
+
+	stats->count++;
+	stats->total_ns += ns;
+	if (ns > stats->max_ns)
+		stats->max_ns = ns;
+}
+#else
+static inline u64 rtl8366_smi_stats_start(void) { return 0; }
+static inline void rtl8366_smi_stats_account(struct rtl8366_smi *smi, int dir,
+					     u64 start) {}
+#endif
+
+/*
+ * Accesses are serialized by a mutex, and the bit-banged transfers run
+ * with interrupts and preemption enabled; SMI is clocked by the host, so
+ * the switch does not mind if a transfer gets stretched.
+ */
+static void rtl8366_smi_lock(struct rtl8366_smi *smi)
+{
+	mutex_lock(&smi->lock);
+}
+
+static void rtl8366_smi_unlock(struct rtl8366_smi *smi)
+{
+	mutex_unlock(&smi->lock);
+	cond_resched();
+}
+
+static int rtl8366_smi_xfer_read(struct rtl8366_smi *smi, u32 addr, u32 *data)
+{
+	u64 start = rtl8366_smi_stats_start();
+	int ret;
+
 	if (smi->ext_mbus)
-		return __rtl8366_mdio_read_reg(smi, addr, data);
+		ret = __rtl8366_mdio_read_reg(smi, addr, data);
 	else
-		return __rtl8366_smi_read_reg(smi, addr, data);
+		ret = __rtl8366_smi_read_reg(smi, addr, data);
+
+	rtl8366_smi_stats_account(smi, RTL8366_SMI_STATS_READ, start);
+
+	return ret;
+}
+
+int rtl8366_smi_read_reg(struct rtl8366_smi *smi, u32 addr, u32 *data)
+{
+	int ret;
+
+	rtl8366_smi_lock(smi);
+	ret = rtl8366_smi_xfer_read(smi, addr, data);
+	rtl8366_smi_unlock(smi);
+
+	return ret;
 }
 EXPORT_SYMBOL_GPL(rtl8366_smi_read_reg);
 
+/* read 'count' consecutive registers without giving up the bus */
+int rtl8366_smi_read_regs(struct rtl8366_smi *smi, u32 addr, u32 *data,
+			  unsigned int count)
+{
+	unsigned int i;
+	int ret = 0;
+
+	rtl8366_smi_lock(smi);
+	for (i = 0; i < count && !ret; i++)
+		ret = rtl8366_smi_xfer_read(smi, addr + i, &data[i]);
+	rtl8366_smi_unlock(smi);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(rtl8366_smi_read_regs);
+
 static int __rtl8366_smi_write_reg(struct rtl8366_smi *smi,
 				   u32 addr, u32 data, bool ack)
 {
-	unsigned long flags;
 	int ret;
 
-	spin_lock_irqsave(&smi->lock, flags);
-
 	rtl8366_smi_start(smi);
 
 	/* send WRITE command */
@@ -379,23 +447,42 @@ static int __rtl8366_smi_write_reg(struct rtl8366_smi *smi,
 
  out:
 	rtl8366_smi_stop(smi);
-	spin_unlock_irqrestore(&smi->lock, flags);
 
 	return ret;
 }
 
 int rtl8366_smi_write_reg(struct rtl8366_smi *smi, u32 addr, u32 data)
 {
+	u64 start;
+	int ret;
+
+	rtl8366_smi_lock(smi);
+	start = rtl8366_smi_stats_start();
+
 	if (smi->ext_mbus)
-		return __rtl8366_mdio_write_reg(smi, addr, data);
+		ret = __rtl8366_mdio_write_reg(smi, addr, data);
 	else
-		return __rtl8366_smi_write_reg(smi, addr, data, true);
+		ret = __rtl8366_smi_write_reg(smi, addr, data, true);
+
+	rtl8366_smi_stats_account(smi, RTL8366_SMI_STATS_WRITE, start);
+	rtl8366_smi_unlock(smi);
+
+	return ret;
 }
 EXPORT_SYMBOL_GPL(rtl8366_smi_write_reg);
 
 int rtl8366_smi_write_reg_noack(struct rtl8366_smi *smi, u32 addr, u32 data)
 {
-	return __rtl8366_smi_write_reg(smi, addr, data, false);
+	u64 start;
+	int ret;
+
+	rtl8366_smi_lock(smi);
+	start = rtl8366_smi_stats_start();
+	ret = __rtl8366_smi_write_reg(smi, addr, data, false);
+	rtl8366_smi_stats_account(smi, RTL8366_SMI_STATS_WRITE, start);
+	rtl8366_smi_unlock(smi);
+
+	return ret;
 }
 EXPORT_SYMBOL_GPL(rtl8366_smi_write_reg_noack);
 
@@ -898,6 +985,52 @@ static ssize_t rtl8366_read_debugfs_mibs(struct file *file,
 	return simple_read_from_buffer(user_buf, count, ppos, buf, len);
 }
 
+static ssize_t rtl8366_read_debugfs_smi_stats(struct file *file,
+					      char __user *user_buf,
+					      size_t count, loff_t *ppos)
+{
+	static const char * const names[] = {
+		[RTL8366_SMI_STATS_READ] = "read",
+		[RTL8366_SMI_STATS_WRITE] = "write",
+	};
+	struct rtl8366_smi *smi = file->private_data;
+	int i, len = 0;
+	char *buf = smi->buf;
+
+	len += snprintf(buf + len, sizeof(smi->buf) - len, "%-6s %12s %12s %12s\n",
+			"access", "count", "avg (ns)", "max (ns)");
+
+	mutex_lock(&smi->lock);
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		struct rtl8366_smi_stats *stats = &smi->dbg_stats[i];
+		u64 avg = 0;
+
+		if (stats->count)
+			avg = div64_u64(stats->total_ns, stats->count);
+
+		len += snprintf(buf + len, sizeof(smi->buf) - len,
+				"%-6s %12llu %12llu %12llu\n", names[i],
+				stats->count, avg, stats->max_ns);
+	}
+	mutex_unlock(&smi->lock);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, len);
+}
+
+static ssize_t rtl8366_write_debugfs_smi_stats(struct file *file,
+					       const char __user *user_buf,
+					       size_t count, loff_t *ppos)
+{
+	struct rtl8366_smi *smi = file->private_data;
+
+	/* any write resets the statistics */
+	mutex_lock(&smi->lock);
+	memset(smi->dbg_stats, 0, sizeof(smi->dbg_stats));
+	mutex_unlock(&smi->lock);
+
+	return count;
+}
+
 static const struct file_operations fops_rtl8366_regs = {
 	.read	= rtl8366_read_debugfs_reg,
 	.write	= rtl8366_write_debugfs_reg,
@@ -929,6 +1062,13 @@ static const struct file_operations fops_rtl8366_mibs = {
 	.owner = THIS_MODULE
 };
 
+static const struct file_operations fops_rtl8366_smi_stats = {
+	.read	= rtl8366_read_debugfs_smi_stats,
+	.write	= rtl8366_write_debugfs_smi_stats,
+	.open	= rtl8366_debugfs_open,
+	.owner	= THIS_MODULE
+};
+
 static void rtl8366_debugfs_init(struct rtl8366_smi *smi)
 {
 	struct dentry *node;
@@ -994,9 +1134,17 @@ static void rtl8366_debugfs_init(struct rtl8366_smi *smi)
 
 	node = debugfs_create_file("mibs", S_IRUSR, smi->debugfs_root, smi,
 				   &fops_rtl8366_mibs);
-	if (!node)
+	if (!node) {
 		dev_err(smi->parent, "Creating debugfs file '%s' failed\n",
 			"mibs");
+		return;
+	}
+
+	node = debugfs_create_file("smi_stats", S_IRUSR | S_IWUSR, root, smi,
+				   &fops_rtl8366_smi_stats);
+	if (!node)
+		dev_err(smi->parent, "Creating debugfs file '%s' failed\n",
+			"smi_stats");
 }
 
 static void rtl8366_debugfs_remove(struct rtl8366_smi *smi)
@@ -1388,7 +1536,7 @@ static int __rtl8366_smi_init(struct rtl8366_smi *smi, const char *name)
 		}
 	}
 
-	spin_lock_init(&smi->lock);
+	mutex_init(&smi->lock);
 
 	/* start the switch */
 	if (smi->hw_reset) {
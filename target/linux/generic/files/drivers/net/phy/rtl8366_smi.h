@@ -11,6 +11,7 @@
 #ifndef _RTL8366_SMI_H
 #define _RTL8366_SMI_H
 
+#include <linux/mutex.h>
 #include <linux/phy.h>
 #include <linux/switch.h>
 #include <linux/platform_device.h>
@@ -30,6 +31,18 @@ struct rtl8366_mib_counter {
 	const char	*name;
 };
 
+enum {
+	RTL8366_SMI_STATS_READ,
+	RTL8366_SMI_STATS_WRITE,
+	RTL8366_SMI_STATS_NUM,
+};
+
+struct rtl8366_smi_stats {
+	u64	count;
+	u64	total_ns;
+	u64	max_ns;
+};
+
 struct rtl8366_smi {
 	struct device		*parent;
 	unsigned int		gpio_sda;
@@ -38,7 +51,7 @@ struct rtl8366_smi {
 	unsigned int		clk_delay;	/* ns */
 	u8			cmd_read;
 	u8			cmd_write;
-	spinlock_t		lock;
+	struct mutex		lock;
 	struct mii_bus		*mii_bus;
 	int			mii_irq[PHY_MAX_ADDR];
 	struct switch_dev	sw_dev;
@@ -62,6 +75,7 @@ struct rtl8366_smi {
 	struct dentry           *debugfs_root;
 	u16			dbg_reg;
 	u8			dbg_vlan_4k_page;
+	struct rtl8366_smi_stats dbg_stats[RTL8366_SMI_STATS_NUM];
 #endif
 	struct mii_bus		*ext_mbus;
 };
@@ -113,6 +127,8 @@ void rtl8366_smi_cleanup(struct rtl8366_smi *smi);
 int rtl8366_smi_write_reg(struct rtl8366_smi *smi, u32 addr, u32 data);
 int rtl8366_smi_write_reg_noack(struct rtl8366_smi *smi, u32 addr, u32 data);
 int rtl8366_smi_read_reg(struct rtl8366_smi *smi, u32 addr, u32 *data);
+int rtl8366_smi_read_regs(struct rtl8366_smi *smi, u32 addr, u32 *data,
+			  unsigned int count);
 int rtl8366_smi_rmwr(struct rtl8366_smi *smi, u32 addr, u32 mask, u32 data);
 
 int rtl8366_reset_vlan(struct rtl8366_smi *smi);
@@ -404,7 +404,7 @@ static int rtl8366rb_get_mib_counter(struct rtl8366_smi *smi, int counter,
 {
 	int i;
 	int err;
-	u32 addr, data;
+	u32 addr, data, words[4];
 	u64 mibvalue;
 
 	if (port > RTL8366RB_NUM_PORTS || counter >= RTL8366RB_MIB_COUNT)
@@ -434,14 +434,14 @@ static int rtl8366rb_get_mib_counter(struct rtl8366_smi *smi, int counter,
 	if (data & RTL8366RB_MIB_CTRL_RESET_MASK)
 		return -EIO;
 
-	mibvalue = 0;
-	for (i = rtl8366rb_mib_counters[counter].length; i > 0; i--) {
-		err = rtl8366_smi_read_reg(smi, addr + (i - 1), &data);
-		if (err)
-			return err;
+	err = rtl8366_smi_read_regs(smi, addr, words,
+				    rtl8366rb_mib_counters[counter].length);
+	if (err)
+		return err;
 
-		mibvalue = (mibvalue << 16) | (data & 0xFFFF);
-	}
+	mibvalue = 0;
+	for (i = rtl8366rb_mib_counters[counter].length; i > 0; i--)
+		mibvalue = (mibvalue << 16) | (words[i - 1] & 0xFFFF);
 
 	*val = mibvalue;
 	return 0;
@@ -452,7 +452,6 @@ static int rtl8366rb_get_vlan_4k(struct rtl8366_smi *smi, u32 vid,
 {
 	u32 data[3];
 	int err;
-	int i;
 
 	memset(vlan4k, '\0', sizeof(struct rtl8366_vlan_4k));
 
@@ -471,13 +470,9 @@ static int rtl8366rb_get_vlan_4k(struct rtl8366_smi *smi, u32 vid,
 	if (err)
 		return err;
 
-	for (i = 0; i < 3; i++) {
-		err = rtl8366_smi_read_reg(smi,
-					   RTL8366RB_VLAN_TABLE_READ_BASE + i,
-					   &data[i]);
-		if (err)
-			return err;
-	}
+	err = rtl8366_smi_read_regs(smi, RTL8366RB_VLAN_TABLE_READ_BASE, data, 3);
+	if (err)
+		return err;
 
 	vlan4k->vid = vid;
 	vlan4k->untag = (data[1] >> RTL8366RB_VLAN_UNTAG_SHIFT) &
@@ -527,20 +522,15 @@ static int rtl8366rb_get_vlan_mc(struct rtl8366_smi *smi, u32 index,
 {
 	u32 data[3];
 	int err;
-	int i;
 
 	memset(vlanmc, '\0', sizeof(struct rtl8366_vlan_mc));
 
 	if (index >= RTL8366RB_NUM_VLANS)
 		return -EINVAL;
 
-	for (i = 0; i < 3; i++) {
-		err = rtl8366_smi_read_reg(smi,
-					   RTL8366RB_VLAN_MC_BASE(index) + i,
-					   &data[i]);
-		if (err)
-			return err;
-	}
+	err = rtl8366_smi_read_regs(smi, RTL8366RB_VLAN_MC_BASE(index), data, 3);
+	if (err)
+		return err;
 
 	vlanmc->vid = data[0] & RTL8366RB_VLAN_VID_MASK;
 	vlanmc->priority = (data[0] >> RTL8366RB_VLAN_PRIORITY_SHIFT) &
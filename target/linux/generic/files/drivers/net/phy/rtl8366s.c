@@ -454,7 +454,7 @@ static int rtl8366_get_mib_counter(struct rtl8366_smi *smi, int counter,
 {
 	int i;
 	int err;
-	u32 addr, data;
+	u32 addr, data, words[4];
 	u64 mibvalue;
 
 	if (port > RTL8366S_NUM_PORTS || counter >= RTL8366S_MIB_COUNT)
@@ -497,14 +497,14 @@ static int rtl8366_get_mib_counter(struct rtl8366_smi *smi, int counter,
 	if (data & RTL8366S_MIB_CTRL_RESET_MASK)
 		return -EIO;
 
-	mibvalue = 0;
-	for (i = rtl8366s_mib_counters[counter].length; i > 0; i--) {
-		err = rtl8366_smi_read_reg(smi, addr + (i - 1), &data);
-		if (err)
-			return err;
+	err = rtl8366_smi_read_regs(smi, addr, words,
+				    rtl8366s_mib_counters[counter].length);
+	if (err)
+		return err;
 
-		mibvalue = (mibvalue << 16) | (data & 0xFFFF);
-	}
+	mibvalue = 0;
+	for (i = rtl8366s_mib_counters[counter].length; i > 0; i--)
+		mibvalue = (mibvalue << 16) | (words[i - 1] & 0xFFFF);
 
 	*val = mibvalue;
 	return 0;
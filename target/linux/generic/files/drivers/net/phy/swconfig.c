@@ -22,6 +22,8 @@
 #include <linux/if_ether.h>
 #include <linux/capability.h>
 #include <linux/skbuff.h>
+#include <linux/bitmap.h>
+#include <linux/workqueue.h>
 #include <linux/switch.h>
 #include <linux/of.h>
 #include <linux/version.h>
@@ -34,6 +36,11 @@
 MODULE_AUTHOR("Felix Fietkau <nbd@nbd.name>");
 MODULE_LICENSE("GPL");
 
+static unsigned int stats_interval;
+module_param(stats_interval, uint, 0644);
+MODULE_PARM_DESC(stats_interval,
+		 "Interval in seconds for port counter events (0 = disabled)");
+
 static int swdev_id;
 static struct list_head swdevs;
 static DEFINE_MUTEX(swdevs_lock);
@@ -280,6 +287,8 @@ static const struct nla_policy switch_policy[SWITCH_ATTR_MAX+1] = {
 	[SWITCH_ATTR_OP_VALUE_STR] = { .type = NLA_NUL_STRING },
 	[SWITCH_ATTR_OP_VALUE_PORTS] = { .type = NLA_NESTED },
 	[SWITCH_ATTR_TYPE] = { .type = NLA_U32 },
+	[SWITCH_ATTR_OP_CMD] = { .type = NLA_U32 },
+	[SWITCH_ATTR_OPS] = { .type = NLA_NESTED },
 };
 
 static const struct nla_policy port_policy[SWITCH_PORT_ATTR_MAX+1] = {
@@ -306,16 +315,11 @@ swconfig_unlock(void)
 }
 
 static struct switch_dev *
-swconfig_get_dev(struct genl_info *info)
+swconfig_get_dev_by_id(int id)
 {
 	struct switch_dev *dev = NULL;
 	struct switch_dev *p;
-	int id;
-
-	if (!info->attrs[SWITCH_ATTR_ID])
-		goto done;
 
-	id = nla_get_u32(info->attrs[SWITCH_ATTR_ID]);
 	swconfig_lock();
 	list_for_each_entry(p, &swdevs, dev_list) {
 		if (id != p->id)
@@ -329,10 +333,19 @@ swconfig_get_dev(struct genl_info *info)
 	else
 		pr_debug("device %d not found\n", id);
 	swconfig_unlock();
-done:
+
 	return dev;
 }
 
+static struct switch_dev *
+swconfig_get_dev(struct genl_info *info)
+{
+	if (!info->attrs[SWITCH_ATTR_ID])
+		return NULL;
+
+	return swconfig_get_dev_by_id(nla_get_u32(info->attrs[SWITCH_ATTR_ID]));
+}
+
 static inline void
 swconfig_put_dev(struct switch_dev *dev)
 {
@@ -494,10 +507,9 @@ out:
 }
 
 static const struct switch_attr *
-swconfig_lookup_attr(struct switch_dev *dev, struct genl_info *info,
+swconfig_lookup_attr(struct switch_dev *dev, int cmd, struct nlattr **attrs,
 		struct switch_val *val)
 {
-	struct genlmsghdr *hdr = nlmsg_data(info->nlhdr);
 	const struct switch_attrlist *alist;
 	const struct switch_attr *attr = NULL;
 	unsigned int attr_id;
@@ -507,10 +519,10 @@ swconfig_lookup_attr(struct switch_dev *dev, struct genl_info *info,
 	unsigned long *def_active;
 	int n_def;
 
-	if (!info->attrs[SWITCH_ATTR_OP_ID])
+	if (!attrs[SWITCH_ATTR_OP_ID])
 		goto done;
 
-	switch (hdr->cmd) {
+	switch (cmd) {
 	case SWITCH_CMD_SET_GLOBAL:
 	case SWITCH_CMD_GET_GLOBAL:
 		alist = &dev->ops->attr_global;
@@ -524,9 +536,9 @@ swconfig_lookup_attr(struct switch_dev *dev, struct genl_info *info,
 		def_list = default_vlan;
 		def_active = &dev->def_vlan;
 		n_def = ARRAY_SIZE(default_vlan);
-		if (!info->attrs[SWITCH_ATTR_OP_VLAN])
+		if (!attrs[SWITCH_ATTR_OP_VLAN])
 			goto done;
-		val->port_vlan = nla_get_u32(info->attrs[SWITCH_ATTR_OP_VLAN]);
+		val->port_vlan = nla_get_u32(attrs[SWITCH_ATTR_OP_VLAN]);
 		if (val->port_vlan >= dev->vlans)
 			goto done;
 		break;
@@ -536,9 +548,9 @@ swconfig_lookup_attr(struct switch_dev *dev, struct genl_info *info,
 		def_list = default_port;
 		def_active = &dev->def_port;
 		n_def = ARRAY_SIZE(default_port);
-		if (!info->attrs[SWITCH_ATTR_OP_PORT])
+		if (!attrs[SWITCH_ATTR_OP_PORT])
 			goto done;
-		val->port_vlan = nla_get_u32(info->attrs[SWITCH_ATTR_OP_PORT]);
+		val->port_vlan = nla_get_u32(attrs[SWITCH_ATTR_OP_PORT]);
 		if (val->port_vlan >= dev->ports)
 			goto done;
 		break;
@@ -550,7 +562,7 @@ swconfig_lookup_attr(struct switch_dev *dev, struct genl_info *info,
 	if (!alist)
 		goto done;
 
-	attr_id = nla_get_u32(info->attrs[SWITCH_ATTR_OP_ID]);
+	attr_id = nla_get_u32(attrs[SWITCH_ATTR_OP_ID]);
 	if (attr_id >= SWITCH_ATTR_DEFAULTS_OFFSET) {
 		attr_id -= SWITCH_ATTR_DEFAULTS_OFFSET;
 		if (attr_id >= n_def)
@@ -624,22 +636,14 @@ swconfig_parse_link(struct sk_buff *msg, struct nlattr *nla,
 }
 
 static int
-swconfig_set_attr(struct sk_buff *skb, struct genl_info *info)
+swconfig_set_op(struct switch_dev *dev, int cmd, struct nlattr **attrs)
 {
 	const struct switch_attr *attr;
-	struct switch_dev *dev;
 	struct switch_val val;
 	int err = -EINVAL;
 
-	if (!capable(CAP_NET_ADMIN))
-		return -EPERM;
-
-	dev = swconfig_get_dev(info);
-	if (!dev)
-		return -EINVAL;
-
 	memset(&val, 0, sizeof(val));
-	attr = swconfig_lookup_attr(dev, info, &val);
+	attr = swconfig_lookup_attr(dev, cmd, attrs, &val);
 	if (!attr || !attr->set)
 		goto error;
 
@@ -648,16 +652,16 @@ swconfig_set_attr(struct sk_buff *skb, struct genl_info *info)
 	case SWITCH_TYPE_NOVAL:
 		break;
 	case SWITCH_TYPE_INT:
-		if (!info->attrs[SWITCH_ATTR_OP_VALUE_INT])
+		if (!attrs[SWITCH_ATTR_OP_VALUE_INT])
 			goto error;
 		val.value.i =
-			nla_get_u32(info->attrs[SWITCH_ATTR_OP_VALUE_INT]);
+			nla_get_u32(attrs[SWITCH_ATTR_OP_VALUE_INT]);
 		break;
 	case SWITCH_TYPE_STRING:
-		if (!info->attrs[SWITCH_ATTR_OP_VALUE_STR])
+		if (!attrs[SWITCH_ATTR_OP_VALUE_STR])
 			goto error;
 		val.value.s =
-			nla_data(info->attrs[SWITCH_ATTR_OP_VALUE_STR]);
+			nla_data(attrs[SWITCH_ATTR_OP_VALUE_STR]);
 		break;
 	case SWITCH_TYPE_PORTS:
 		val.value.ports = dev->portbuf;
@@ -665,9 +669,9 @@ swconfig_set_attr(struct sk_buff *skb, struct genl_info *info)
 			sizeof(struct switch_port) * dev->ports);
 
 		/* TODO: implement multipart? */
-		if (info->attrs[SWITCH_ATTR_OP_VALUE_PORTS]) {
-			err = swconfig_parse_ports(skb,
-				info->attrs[SWITCH_ATTR_OP_VALUE_PORTS],
+		if (attrs[SWITCH_ATTR_OP_VALUE_PORTS]) {
+			err = swconfig_parse_ports(NULL,
+				attrs[SWITCH_ATTR_OP_VALUE_PORTS],
 				&val, dev->ports);
 			if (err < 0)
 				goto error;
@@ -680,9 +684,9 @@ swconfig_set_attr(struct sk_buff *skb, struct genl_info *info)
 		val.value.link = &dev->linkbuf;
 		memset(&dev->linkbuf, 0, sizeof(struct switch_port_link));
 
-		if (info->attrs[SWITCH_ATTR_OP_VALUE_LINK]) {
-			err = swconfig_parse_link(skb,
-						  info->attrs[SWITCH_ATTR_OP_VALUE_LINK],
+		if (attrs[SWITCH_ATTR_OP_VALUE_LINK]) {
+			err = swconfig_parse_link(NULL,
+						  attrs[SWITCH_ATTR_OP_VALUE_LINK],
 						  val.value.link);
 			if (err < 0)
 				goto error;
@@ -697,6 +701,73 @@ swconfig_set_attr(struct sk_buff *skb, struct genl_info *info)
 
 	err = attr->set(dev, attr, &val);
 error:
+	return err;
+}
+
+static int
+swconfig_set_attr(struct sk_buff *skb, struct genl_info *info)
+{
+	struct genlmsghdr *hdr = nlmsg_data(info->nlhdr);
+	struct switch_dev *dev;
+	int err;
+
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+
+	dev = swconfig_get_dev(info);
+	if (!dev)
+		return -EINVAL;
+
+	err = swconfig_set_op(dev, hdr->cmd, info->attrs);
+	swconfig_put_dev(dev);
+	return err;
+}
+
+/*
+ * Executes a list of set operations under a single device lock. All of
+ * them are attempted in order, the first error is returned.
+ */
+static int
+swconfig_set_bulk(struct sk_buff *skb, struct genl_info *info)
+{
+	struct nlattr *tb[SWITCH_ATTR_MAX + 1];
+	struct switch_dev *dev;
+	struct nlattr *nla;
+	int err = 0;
+	int rem;
+
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+
+	if (!info->attrs[SWITCH_ATTR_OPS])
+		return -EINVAL;
+
+	dev = swconfig_get_dev(info);
+	if (!dev)
+		return -EINVAL;
+
+	nla_for_each_nested(nla, info->attrs[SWITCH_ATTR_OPS], rem) {
+		int ret = -EINVAL;
+		int cmd;
+
+		if (nla_parse_nested_deprecated(tb, SWITCH_ATTR_MAX, nla,
+				switch_policy, NULL) || !tb[SWITCH_ATTR_OP_CMD])
+			goto next;
+
+		cmd = nla_get_u32(tb[SWITCH_ATTR_OP_CMD]);
+		switch (cmd) {
+		case SWITCH_CMD_SET_GLOBAL:
+		case SWITCH_CMD_SET_VLAN:
+		case SWITCH_CMD_SET_PORT:
+			ret = swconfig_set_op(dev, cmd, tb);
+			break;
+		}
+
+next:
+		if (ret && !err)
+			err = ret;
+	}
+
 	swconfig_put_dev(dev);
 	return err;
 }
@@ -837,7 +908,7 @@ swconfig_get_attr(struct sk_buff *skb, struct genl_info *info)
 		return -EINVAL;
 
 	memset(&val, 0, sizeof(val));
-	attr = swconfig_lookup_attr(dev, info, &val);
+	attr = swconfig_lookup_attr(dev, cmd, info->attrs, &val);
 	if (!attr || !attr->get)
 		goto error;
 
@@ -988,6 +1059,511 @@ swconfig_done(struct netlink_callback *cb)
 	return 0;
 }
 
+enum swconfig_dump_groups {
+	SWCONFIG_DUMP_GLOBAL,
+	SWCONFIG_DUMP_PORT,
+	SWCONFIG_DUMP_VLAN,
+	__SWCONFIG_DUMP_MAX
+};
+
+struct swconfig_attr_group {
+	int cmd;
+	int n;
+	const struct switch_attrlist *alist;
+	const struct switch_attr *def_list;
+	unsigned long def_active;
+	int n_def;
+};
+
+static void
+swconfig_get_attr_group(struct switch_dev *dev, int group,
+			struct swconfig_attr_group *g)
+{
+	switch (group) {
+	case SWCONFIG_DUMP_GLOBAL:
+		g->cmd = SWITCH_CMD_GET_GLOBAL;
+		g->n = 1;
+		g->alist = &dev->ops->attr_global;
+		g->def_list = default_global;
+		g->def_active = dev->def_global;
+		g->n_def = ARRAY_SIZE(default_global);
+		break;
+	case SWCONFIG_DUMP_PORT:
+		g->cmd = SWITCH_CMD_GET_PORT;
+		g->n = dev->ports;
+		g->alist = &dev->ops->attr_port;
+		g->def_list = default_port;
+		g->def_active = dev->def_port;
+		g->n_def = ARRAY_SIZE(default_port);
+		break;
+	case SWCONFIG_DUMP_VLAN:
+		g->cmd = SWITCH_CMD_GET_VLAN;
+		g->n = dev->vlans;
+		g->alist = &dev->ops->attr_vlan;
+		g->def_list = default_vlan;
+		g->def_active = dev->def_vlan;
+		g->n_def = ARRAY_SIZE(default_vlan);
+		break;
+	}
+}
+
+static int
+swconfig_put_ports(struct sk_buff *msg, const struct switch_val *val)
+{
+	struct nlattr *n, *p;
+	int i;
+
+	n = nla_nest_start(msg, SWITCH_ATTR_OP_VALUE_PORTS);
+	if (!n)
+		return -EMSGSIZE;
+
+	for (i = 0; i < val->len; i++) {
+		const struct switch_port *port = &val->value.ports[i];
+
+		p = nla_nest_start(msg, SWITCH_ATTR_PORT);
+		if (!p)
+			goto nla_put_failure;
+		if (nla_put_u32(msg, SWITCH_PORT_ID, port->id))
+			goto nla_put_failure;
+		if ((port->flags & (1 << SWITCH_PORT_FLAG_TAGGED)) &&
+		    nla_put_flag(msg, SWITCH_PORT_FLAG_TAGGED))
+			goto nla_put_failure;
+		nla_nest_end(msg, p);
+	}
+	nla_nest_end(msg, n);
+
+	return 0;
+
+nla_put_failure:
+	nla_nest_cancel(msg, n);
+	return -EMSGSIZE;
+}
+
+static int
+swconfig_dump_value(struct sk_buff *msg, struct netlink_callback *cb,
+		    struct switch_dev *dev, const struct swconfig_attr_group *g,
+		    const struct switch_attr *attr, int id, int port_vlan)
+{
+	struct switch_val val;
+	void *hdr;
+
+	hdr = genlmsg_put(msg, NETLINK_CB(cb->skb).portid, cb->nlh->nlmsg_seq,
+			  &switch_fam, NLM_F_MULTI, SWITCH_CMD_GET_BULK);
+	if (!hdr)
+		return -EMSGSIZE;
+
+	if (nla_put_u32(msg, SWITCH_ATTR_OP_CMD, g->cmd))
+		goto nla_put_failure;
+	if (nla_put_u32(msg, SWITCH_ATTR_OP_ID, id))
+		goto nla_put_failure;
+	if (g->cmd == SWITCH_CMD_GET_PORT &&
+	    nla_put_u32(msg, SWITCH_ATTR_OP_PORT, port_vlan))
+		goto nla_put_failure;
+	if (g->cmd == SWITCH_CMD_GET_VLAN &&
+	    nla_put_u32(msg, SWITCH_ATTR_OP_VLAN, port_vlan))
+		goto nla_put_failure;
+
+	memset(&val, 0, sizeof(val));
+	val.attr = attr;
+	val.port_vlan = port_vlan;
+	if (attr->type == SWITCH_TYPE_PORTS) {
+		val.value.ports = dev->portbuf;
+		memset(dev->portbuf, 0,
+			sizeof(struct switch_port) * dev->ports);
+	} else if (attr->type == SWITCH_TYPE_LINK) {
+		val.value.link = &dev->linkbuf;
+		memset(&dev->linkbuf, 0, sizeof(struct switch_port_link));
+	}
+
+	/* attributes which cannot be read are sent without a value */
+	if (!attr->get || attr->get(dev, attr, &val))
+		goto done;
+
+	switch (attr->type) {
+	case SWITCH_TYPE_INT:
+		if (nla_put_u32(msg, SWITCH_ATTR_OP_VALUE_INT, val.value.i))
+			goto nla_put_failure;
+		break;
+	case SWITCH_TYPE_STRING:
+		if (val.value.s &&
+		    nla_put_string(msg, SWITCH_ATTR_OP_VALUE_STR, val.value.s))
+			goto nla_put_failure;
+		break;
+	case SWITCH_TYPE_PORTS:
+		if (swconfig_put_ports(msg, &val) < 0)
+			goto nla_put_failure;
+		break;
+	case SWITCH_TYPE_LINK:
+		if (swconfig_send_link(msg, NULL, SWITCH_ATTR_OP_VALUE_LINK,
+				       val.value.link) < 0)
+			goto nla_put_failure;
+		break;
+	}
+
+done:
+	genlmsg_end(msg, hdr);
+	return 0;
+
+nla_put_failure:
+	genlmsg_cancel(msg, hdr);
+	return -EMSGSIZE;
+}
+
+/*
+ * Dumps the values of all readable global, port and vlan attributes of a
+ * device, in the order they are listed in. The device is only looked up
+ * and locked once per message buffer.
+ */
+static int
+swconfig_dump_attrs(struct sk_buff *skb, struct netlink_callback *cb)
+{
+	struct swconfig_attr_group g;
+	struct switch_dev *dev;
+	int group = cb->args[1];
+	int idx = cb->args[2];
+	int i = cb->args[3];
+	int sent = 0;
+	int err = 0;
+
+	if (!cb->args[0]) {
+		struct nlattr *tb[SWITCH_ATTR_MAX + 1];
+
+		if (nlmsg_parse_deprecated(cb->nlh, GENL_HDRLEN, tb,
+				SWITCH_ATTR_MAX, switch_policy, NULL) ||
+		    !tb[SWITCH_ATTR_ID])
+			return -EINVAL;
+
+		cb->args[0] = nla_get_u32(tb[SWITCH_ATTR_ID]);
+	}
+
+	dev = swconfig_get_dev_by_id(cb->args[0]);
+	if (!dev)
+		return -ENODEV;
+
+	for (; group < __SWCONFIG_DUMP_MAX; group++, idx = 0, i = 0) {
+		swconfig_get_attr_group(dev, group, &g);
+
+		for (; idx < g.n; idx++, i = 0) {
+			for (; i < g.alist->n_attr + g.n_def; i++) {
+				const struct switch_attr *attr;
+				int id = i;
+
+				if (i < g.alist->n_attr) {
+					attr = &g.alist->attr[i];
+				} else {
+					id -= g.alist->n_attr;
+					if (!test_bit(id, &g.def_active))
+						continue;
+					attr = &g.def_list[id];
+					id += SWITCH_ATTR_DEFAULTS_OFFSET;
+				}
+
+				if (attr->disabled ||
+				    attr->type == SWITCH_TYPE_NOVAL)
+					continue;
+
+				if (swconfig_dump_value(skb, cb, dev, &g, attr,
+							id, idx) < 0) {
+					if (!sent)
+						err = -EMSGSIZE;
+					goto out;
+				}
+				sent++;
+			}
+		}
+	}
+
+out:
+	swconfig_put_dev(dev);
+	cb->args[1] = group;
+	cb->args[2] = idx;
+	cb->args[3] = i;
+
+	return err ? err : skb->len;
+}
+
+/* link and counter events */
+
+#define SWCONFIG_EVENT_INTERVAL	HZ
+
+enum swconfig_multicast_groups {
+	SWCONFIG_MCGRP_EVENTS,
+};
+
+static const struct genl_multicast_group swconfig_mcgrps[] = {
+	[SWCONFIG_MCGRP_EVENTS] = { .name = SWITCH_MCGRP_EVENTS },
+};
+
+struct swconfig_events {
+	struct switch_dev *dev;
+	struct delayed_work work;
+
+	unsigned long *pending;
+	struct switch_port_link *link;
+	struct switch_port_stats *stats;
+	unsigned long stats_next;
+	bool stats_valid;
+};
+
+static inline bool
+swconfig_has_listeners(void)
+{
+	return genl_has_listeners(&switch_fam, &init_net,
+				  SWCONFIG_MCGRP_EVENTS);
+}
+
+static bool
+swconfig_link_equal(const struct switch_port_link *a,
+		    const struct switch_port_link *b)
+{
+	if (a->link != b->link)
+		return false;
+
+	if (!a->link)
+		return true;
+
+	return a->duplex == b->duplex &&
+	       a->aneg == b->aneg &&
+	       a->tx_flow == b->tx_flow &&
+	       a->rx_flow == b->rx_flow &&
+	       a->speed == b->speed &&
+	       a->eee == b->eee;
+}
+
+static void *
+swconfig_event_put(struct sk_buff *msg, struct switch_dev *dev, int port,
+		   int cmd)
+{
+	void *hdr;
+
+	hdr = genlmsg_put(msg, 0, 0, &switch_fam, 0, cmd);
+	if (!hdr)
+		return NULL;
+
+	if (nla_put_u32(msg, SWITCH_ATTR_ID, dev->id) ||
+	    nla_put_string(msg, SWITCH_ATTR_DEV_NAME, dev->devname) ||
+	    nla_put_u32(msg, SWITCH_ATTR_OP_PORT, port)) {
+		genlmsg_cancel(msg, hdr);
+		return NULL;
+	}
+
+	return hdr;
+}
+
+static int
+swconfig_send_link_event(struct switch_dev *dev, int port,
+			 const struct switch_port_link *link)
+{
+	struct sk_buff *msg;
+	void *hdr;
+
+	msg = nlmsg_new(NLMSG_GOODSIZE, GFP_KERNEL);
+	if (!msg)
+		return -ENOMEM;
+
+	hdr = swconfig_event_put(msg, dev, port, SWITCH_CMD_LINK_EVENT);
+	if (!hdr)
+		goto nla_put_failure;
+
+	if (swconfig_send_link(msg, NULL, SWITCH_ATTR_OP_VALUE_LINK, link) < 0)
+		goto nla_put_failure;
+
+	genlmsg_end(msg, hdr);
+	return genlmsg_multicast(&switch_fam, msg, 0, SWCONFIG_MCGRP_EVENTS,
+				 GFP_KERNEL);
+
+nla_put_failure:
+	nlmsg_free(msg);
+	return -EMSGSIZE;
+}
+
+static int
+swconfig_send_stats_event(struct switch_dev *dev, int port,
+			  u64 tx_bytes, u64 rx_bytes)
+{
+	struct sk_buff *msg;
+	void *hdr;
+
+	msg = nlmsg_new(NLMSG_GOODSIZE, GFP_KERNEL);
+	if (!msg)
+		return -ENOMEM;
+
+	hdr = swconfig_event_put(msg, dev, port, SWITCH_CMD_STATS_EVENT);
+	if (!hdr)
+		goto nla_put_failure;
+
+	if (nla_put_u64_64bit(msg, SWITCH_ATTR_STATS_TX_BYTES, tx_bytes,
+			      SWITCH_ATTR_PAD))
+		goto nla_put_failure;
+	if (nla_put_u64_64bit(msg, SWITCH_ATTR_STATS_RX_BYTES, rx_bytes,
+			      SWITCH_ATTR_PAD))
+		goto nla_put_failure;
+
+	genlmsg_end(msg, hdr);
+	return genlmsg_multicast(&switch_fam, msg, 0, SWCONFIG_MCGRP_EVENTS,
+				 GFP_KERNEL);
+
+nla_put_failure:
+	nlmsg_free(msg);
+	return -EMSGSIZE;
+}
+
+/*
+ * Single producer for the events multicast group. Link state is only
+ * queried for the ports a link_notify driver reported as changed, and
+ * polled for all other drivers. Counter deltas are sent every
+ * stats_interval seconds if enabled. Nothing is read from the hardware
+ * while nobody is subscribed.
+ */
+static void
+swconfig_event_work(struct work_struct *work)
+{
+	struct swconfig_events *ev = container_of(work, struct swconfig_events,
+						  work.work);
+	struct switch_dev *dev = ev->dev;
+	const struct switch_dev_ops *ops = dev->ops;
+	unsigned long interval = 0;
+	unsigned long delay;
+	bool poll_link;
+	bool stats = false;
+	int i;
+
+	if (!swconfig_has_listeners()) {
+		ev->stats_valid = false;
+		return;
+	}
+
+	if (ops->get_port_stats)
+		interval = READ_ONCE(stats_interval) * HZ;
+
+	if (interval && time_after_eq(jiffies, ev->stats_next)) {
+		ev->stats_next = jiffies + interval;
+		stats = true;
+	}
+
+	poll_link = ops->get_port_link && !dev->link_notify;
+
+	mutex_lock(&dev->sw_mutex);
+	for (i = 0; i < dev->ports; i++) {
+		struct switch_port_link link;
+		struct switch_port_stats port_stats;
+
+		if (ops->get_port_link &&
+		    (poll_link || test_and_clear_bit(i, ev->pending))) {
+			memset(&link, 0, sizeof(link));
+			if (!ops->get_port_link(dev, i, &link) &&
+			    !swconfig_link_equal(&link, &ev->link[i])) {
+				ev->link[i] = link;
+				swconfig_send_link_event(dev, i, &link);
+			}
+		}
+
+		if (!stats)
+			continue;
+
+		memset(&port_stats, 0, sizeof(port_stats));
+		if (ops->get_port_stats(dev, i, &port_stats))
+			continue;
+
+		if (ev->stats_valid &&
+		    (port_stats.tx_bytes != ev->stats[i].tx_bytes ||
+		     port_stats.rx_bytes != ev->stats[i].rx_bytes))
+			swconfig_send_stats_event(dev, i,
+				port_stats.tx_bytes - ev->stats[i].tx_bytes,
+				port_stats.rx_bytes - ev->stats[i].rx_bytes);
+
+		ev->stats[i] = port_stats;
+	}
+	mutex_unlock(&dev->sw_mutex);
+
+	if (stats)
+		ev->stats_valid = true;
+
+	if (poll_link)
+		delay = SWCONFIG_EVENT_INTERVAL;
+	else if (interval)
+		delay = interval;
+	else
+		return;
+
+	if (interval)
+		delay = min(delay, ev->stats_next - jiffies);
+
+	schedule_delayed_work(&ev->work, delay);
+}
+
+static int
+swconfig_mcast_bind(struct net *net, int group)
+{
+	struct switch_dev *dev;
+
+	if (group != SWCONFIG_MCGRP_EVENTS)
+		return 0;
+
+	/*
+	 * The new membership is only visible once this returns, so give it
+	 * some time before the producers check for listeners. Ports of
+	 * link_notify drivers are refreshed once, as changes are dropped
+	 * while nobody is subscribed.
+	 */
+	swconfig_lock();
+	list_for_each_entry(dev, &swdevs, dev_list) {
+		if (!dev->events)
+			continue;
+
+		bitmap_fill(dev->events->pending, dev->ports);
+		schedule_delayed_work(&dev->events->work,
+				      SWCONFIG_EVENT_INTERVAL);
+	}
+	swconfig_unlock();
+
+	return 0;
+}
+
+static void
+swconfig_free_events(struct switch_dev *dev)
+{
+	struct swconfig_events *ev = dev->events;
+
+	if (!ev)
+		return;
+
+	cancel_delayed_work_sync(&ev->work);
+	bitmap_free(ev->pending);
+	kfree(ev->link);
+	kfree(ev->stats);
+	kfree(ev);
+	dev->events = NULL;
+}
+
+static int
+swconfig_alloc_events(struct switch_dev *dev)
+{
+	struct swconfig_events *ev;
+
+	if (!dev->ports ||
+	    (!dev->ops->get_port_link && !dev->ops->get_port_stats))
+		return 0;
+
+	ev = kzalloc(sizeof(*ev), GFP_KERNEL);
+	if (!ev)
+		return -ENOMEM;
+
+	ev->dev = dev;
+	INIT_DELAYED_WORK(&ev->work, swconfig_event_work);
+	dev->events = ev;
+
+	ev->pending = bitmap_zalloc(dev->ports, GFP_KERNEL);
+	ev->link = kcalloc(dev->ports, sizeof(*ev->link), GFP_KERNEL);
+	ev->stats = kcalloc(dev->ports, sizeof(*ev->stats), GFP_KERNEL);
+	if (!ev->pending || !ev->link || !ev->stats) {
+		swconfig_free_events(dev);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
 static struct genl_ops swconfig_ops[] = {
 	{
 		.cmd = SWITCH_CMD_LIST_GLOBAL,
@@ -1042,6 +1618,18 @@ static struct genl_ops swconfig_ops[] = {
 		.validate = GENL_DONT_VALIDATE_STRICT | GENL_DONT_VALIDATE_DUMP,
 		.dumpit = swconfig_dump_switches,
 		.done = swconfig_done,
+	},
+	{
+		.cmd = SWITCH_CMD_SET_BULK,
+		.validate = GENL_DONT_VALIDATE_STRICT | GENL_DONT_VALIDATE_DUMP,
+		.flags = GENL_ADMIN_PERM,
+		.doit = swconfig_set_bulk,
+	},
+	{
+		.cmd = SWITCH_CMD_GET_BULK,
+		.validate = GENL_DONT_VALIDATE_STRICT | GENL_DONT_VALIDATE_DUMP,
+		.dumpit = swconfig_dump_attrs,
+		.done = swconfig_done,
 	}
 };
 
@@ -1054,6 +1642,9 @@ static struct genl_family switch_fam = {
 	.module = THIS_MODULE,
 	.ops = swconfig_ops,
 	.n_ops = ARRAY_SIZE(swconfig_ops),
+	.mcgrps = swconfig_mcgrps,
+	.n_mcgrps = ARRAY_SIZE(swconfig_mcgrps),
+	.mcast_bind = swconfig_mcast_bind,
 };
 
 #ifdef CONFIG_OF
@@ -1135,6 +1726,13 @@ register_switch(struct switch_dev *dev, struct net_device *netdev)
 			return -ENOMEM;
 		}
 	}
+	err = swconfig_alloc_events(dev);
+	if (err) {
+		kfree(dev->portmap);
+		kfree(dev->portbuf);
+		return err;
+	}
+
 	swconfig_defaults_init(dev);
 	mutex_init(&dev->sw_mutex);
 	swconfig_lock();
@@ -1152,6 +1750,7 @@ register_switch(struct switch_dev *dev, struct net_device *netdev)
 
 	if (i == max_switches) {
 		swconfig_unlock();
+		swconfig_free_events(dev);
 		return -ENFILE;
 	}
 
@@ -1184,6 +1783,7 @@ unregister_switch(struct switch_dev *dev)
 	list_del(&dev->dev_list);
 	swconfig_unlock();
 	mutex_unlock(&dev->sw_mutex);
+	swconfig_free_events(dev);
 }
 EXPORT_SYMBOL_GPL(unregister_switch);
 
@@ -1224,6 +1824,27 @@ switch_generic_set_link(struct switch_dev *dev, int port,
 }
 EXPORT_SYMBOL_GPL(switch_generic_set_link);
 
+/*
+ * Called by drivers with link change interrupts, so that swconfig can
+ * react to link changes instead of polling for them. Safe to call from
+ * atomic context.
+ */
+void
+switch_port_link_changed(struct switch_dev *dev, int port)
+{
+	struct swconfig_events *ev = dev->events;
+
+	swconfig_led_link_changed(dev, port);
+
+	if (!ev || port < 0 || port >= dev->ports)
+		return;
+
+	set_bit(port, ev->pending);
+	if (swconfig_has_listeners())
+		mod_delayed_work(system_wq, &ev->work, 0);
+}
+EXPORT_SYMBOL_GPL(switch_port_link_changed);
+
 static int __init
 swconfig_init(void)
 {
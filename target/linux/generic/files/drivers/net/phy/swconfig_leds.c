@@ -18,6 +18,7 @@
 #include <linux/workqueue.h>
 
 #define SWCONFIG_LED_TIMER_INTERVAL	(HZ / 10)
+#define SWCONFIG_LED_TIMER_INTERVAL_MAX	HZ
 #define SWCONFIG_LED_NUM_PORTS		32
 
 #define SWCONFIG_LED_PORT_SPEED_NA	0x01	/* unknown speed */
@@ -43,7 +44,10 @@ struct switch_led_trigger {
 	struct switch_dev *swdev;
 
 	struct delayed_work sw_led_work;
+	unsigned long interval;
+	unsigned long link_dirty;
 	u32 port_mask;
+	u32 stats_mask;
 	u32 port_link;
 	unsigned long long port_tx_traffic[SWCONFIG_LED_NUM_PORTS];
 	unsigned long long port_rx_traffic[SWCONFIG_LED_NUM_PORTS];
@@ -77,7 +81,7 @@ swconfig_trig_update_port_mask(struct led_trigger *trigger)
 {
 	struct list_head *entry;
 	struct switch_led_trigger *sw_trig;
-	u32 port_mask;
+	u32 port_mask, stats_mask;
 
 	if (!trigger)
 		return;
@@ -85,6 +89,7 @@ swconfig_trig_update_port_mask(struct led_trigger *trigger)
 	sw_trig = (void *) trigger;
 
 	port_mask = 0;
+	stats_mask = 0;
 	read_lock(&trigger->leddev_list_lock);
 	list_for_each(entry, &trigger->led_cdevs) {
 		struct led_classdev *led_cdev;
@@ -95,18 +100,24 @@ swconfig_trig_update_port_mask(struct led_trigger *trigger)
 		if (trig_data) {
 			read_lock(&trig_data->lock);
 			port_mask |= trig_data->port_mask;
+			if (trig_data->mode & SWCONFIG_LED_MODE_TXRX)
+				stats_mask |= trig_data->port_mask;
 			read_unlock(&trig_data->lock);
 		}
 	}
 	read_unlock(&trigger->leddev_list_lock);
 
 	sw_trig->port_mask = port_mask;
+	sw_trig->stats_mask = stats_mask;
 
-	if (port_mask)
-		schedule_delayed_work(&sw_trig->sw_led_work,
-				      SWCONFIG_LED_TIMER_INTERVAL);
-	else
+	if (port_mask) {
+		/* refresh the link state of all ports right away */
+		sw_trig->link_dirty = ~0UL;
+		sw_trig->interval = SWCONFIG_LED_TIMER_INTERVAL;
+		mod_delayed_work(system_wq, &sw_trig->sw_led_work, 0);
+	} else {
 		cancel_delayed_work_sync(&sw_trig->sw_led_work);
+	}
 }
 
 static ssize_t
@@ -267,6 +278,8 @@ static ssize_t swconfig_trig_mode_store(struct device *dev,
 	trig_data->mode = (u8)new_mode;
 	write_unlock(&trig_data->lock);
 
+	swconfig_trig_update_port_mask(led_cdev->trigger);
+
 	return size;
 }
 
@@ -428,12 +441,37 @@ swconfig_trig_update_leds(struct switch_led_trigger *sw_trig)
 	read_unlock(&trigger->leddev_list_lock);
 }
 
+static u8
+swconfig_led_link_speed(enum switch_port_speed speed)
+{
+	switch (speed) {
+	case SWITCH_PORT_SPEED_10:
+		return SWCONFIG_LED_PORT_SPEED_10;
+	case SWITCH_PORT_SPEED_100:
+		return SWCONFIG_LED_PORT_SPEED_100;
+	case SWITCH_PORT_SPEED_1000:
+		return SWCONFIG_LED_PORT_SPEED_1000;
+	default:
+		return SWCONFIG_LED_PORT_SPEED_NA;
+	}
+}
+
+/*
+ * Link state is only queried for ports reported as changed when the
+ * driver notifies us about link changes, and polled otherwise. Traffic
+ * counters are only read for ports which are up and have an LED in tx
+ * or rx mode bound to them. The polling interval backs off while
+ * nothing changes, and with link notifications polling stops entirely
+ * when there is no traffic to blink for.
+ */
 static void
 swconfig_led_work_func(struct work_struct *work)
 {
 	struct switch_led_trigger *sw_trig;
 	struct switch_dev *swdev;
-	u32 port_mask;
+	u32 port_mask, stats_mask;
+	unsigned long dirty;
+	bool changed = false;
 	u32 link;
 	int i;
 
@@ -441,63 +479,90 @@ swconfig_led_work_func(struct work_struct *work)
 			       sw_led_work.work);
 
 	port_mask = sw_trig->port_mask;
+	stats_mask = sw_trig->stats_mask;
 	swdev = sw_trig->swdev;
 
-	link = 0;
+	if (swdev->link_notify)
+		dirty = xchg(&sw_trig->link_dirty, 0);
+	else
+		dirty = ~0UL;
+
+	link = sw_trig->port_link;
 	for (i = 0; i < SWCONFIG_LED_NUM_PORTS; i++) {
 		u32 port_bit;
 
-		sw_trig->link_speed[i] = 0;
-
 		port_bit = BIT(i);
 		if ((port_mask & port_bit) == 0)
 			continue;
 
-		if (swdev->ops->get_port_link) {
+		if (dirty & port_bit) {
 			struct switch_port_link port_link;
+			u8 speed = 0;
 
 			memset(&port_link, '\0', sizeof(port_link));
 			swdev->ops->get_port_link(swdev, i, &port_link);
 
-			if (port_link.link) {
+			if (port_link.link)
+				speed = swconfig_led_link_speed(port_link.speed);
+
+			if (speed != sw_trig->link_speed[i])
+				changed = true;
+
+			sw_trig->link_speed[i] = speed;
+			if (port_link.link)
 				link |= port_bit;
-				switch (port_link.speed) {
-				case SWITCH_PORT_SPEED_UNKNOWN:
-					sw_trig->link_speed[i] =
-						SWCONFIG_LED_PORT_SPEED_NA;
-					break;
-				case SWITCH_PORT_SPEED_10:
-					sw_trig->link_speed[i] =
-						SWCONFIG_LED_PORT_SPEED_10;
-					break;
-				case SWITCH_PORT_SPEED_100:
-					sw_trig->link_speed[i] =
-						SWCONFIG_LED_PORT_SPEED_100;
-					break;
-				case SWITCH_PORT_SPEED_1000:
-					sw_trig->link_speed[i] =
-						SWCONFIG_LED_PORT_SPEED_1000;
-					break;
-				}
-			}
+			else
+				link &= ~port_bit;
 		}
 
+		if (!(link & stats_mask & port_bit))
+			continue;
+
 		if (swdev->ops->get_port_stats) {
 			struct switch_port_stats port_stats;
 
 			memset(&port_stats, '\0', sizeof(port_stats));
 			swdev->ops->get_port_stats(swdev, i, &port_stats);
+
+			if (port_stats.tx_bytes != sw_trig->port_tx_traffic[i] ||
+			    port_stats.rx_bytes != sw_trig->port_rx_traffic[i])
+				changed = true;
+
 			sw_trig->port_tx_traffic[i] = port_stats.tx_bytes;
 			sw_trig->port_rx_traffic[i] = port_stats.rx_bytes;
 		}
 	}
 
-	sw_trig->port_link = link;
+	sw_trig->port_link = link & port_mask;
 
 	swconfig_trig_update_leds(sw_trig);
 
-	schedule_delayed_work(&sw_trig->sw_led_work,
-			      SWCONFIG_LED_TIMER_INTERVAL);
+	if (changed)
+		sw_trig->interval = SWCONFIG_LED_TIMER_INTERVAL;
+	else
+		sw_trig->interval = min_t(unsigned long, sw_trig->interval * 2,
+					  SWCONFIG_LED_TIMER_INTERVAL_MAX);
+
+	if (swdev->link_notify &&
+	    (!(link & stats_mask) || !swdev->ops->get_port_stats))
+		return;
+
+	schedule_delayed_work(&sw_trig->sw_led_work, sw_trig->interval);
+}
+
+static void
+swconfig_led_link_changed(struct switch_dev *swdev, int port)
+{
+	struct switch_led_trigger *sw_trig = swdev->led_trigger;
+
+	if (!sw_trig || port < 0 || port >= SWCONFIG_LED_NUM_PORTS)
+		return;
+
+	set_bit(port, &sw_trig->link_dirty);
+	if (sw_trig->port_mask & BIT(port)) {
+		sw_trig->interval = SWCONFIG_LED_TIMER_INTERVAL;
+		mod_delayed_work(system_wq, &sw_trig->sw_led_work, 0);
+	}
 }
 
 static int
@@ -514,6 +579,7 @@ swconfig_create_led_trigger(struct switch_dev *swdev)
 		return -ENOMEM;
 
 	sw_trig->swdev = swdev;
+	sw_trig->interval = SWCONFIG_LED_TIMER_INTERVAL;
 	sw_trig->trig.name = swdev->devname;
 	sw_trig->trig.activate = swconfig_trig_activate;
 	sw_trig->trig.deactivate = swconfig_trig_deactivate;
@@ -552,4 +618,7 @@ swconfig_create_led_trigger(struct switch_dev *swdev) { return 0; }
 
 static inline void
 swconfig_destroy_led_trigger(struct switch_dev *swdev) { }
+
+static inline void
+swconfig_led_link_changed(struct switch_dev *swdev, int port) { }
 #endif /* CONFIG_SWCONFIG_LEDS */
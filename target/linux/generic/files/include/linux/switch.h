@@ -25,6 +25,7 @@ struct switch_val;
 struct switch_attr;
 struct switch_attrlist;
 struct switch_led_trigger;
+struct swconfig_events;
 
 int register_switch(struct switch_dev *dev, struct net_device *netdev);
 void unregister_switch(struct switch_dev *dev);
@@ -119,6 +120,9 @@ struct switch_dev {
 	unsigned int vlans;
 	unsigned int cpu_port;
 
+	/* driver reports link changes via switch_port_link_changed() */
+	bool link_notify;
+
 	/* the following fields are internal for swconfig */
 	unsigned int id;
 	struct list_head dev_list;
@@ -131,6 +135,8 @@ struct switch_dev {
 
 	char buf[128];
 
+	struct swconfig_events *events;
+
 #ifdef CONFIG_SWCONFIG_LEDS
 	struct switch_led_trigger *led_trigger;
 #endif
@@ -175,5 +181,6 @@ struct switch_attr {
 
 int switch_generic_set_link(struct switch_dev *dev, int port,
 			    struct switch_port_link *link);
+void switch_port_link_changed(struct switch_dev *dev, int port);
 
 #endif /* _LINUX_SWITCH_H */
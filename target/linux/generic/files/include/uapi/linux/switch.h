@@ -54,6 +54,13 @@ enum {
 	SWITCH_ATTR_OP_DESCRIPTION,
 	/* port lists */
 	SWITCH_ATTR_PORT,
+	/* events */
+	SWITCH_ATTR_PAD,
+	SWITCH_ATTR_STATS_TX_BYTES,
+	SWITCH_ATTR_STATS_RX_BYTES,
+	/* bulk operations */
+	SWITCH_ATTR_OP_CMD,
+	SWITCH_ATTR_OPS,
 	SWITCH_ATTR_MAX
 };
 
@@ -78,9 +85,17 @@ enum {
 	SWITCH_CMD_SET_PORT,
 	SWITCH_CMD_LIST_VLAN,
 	SWITCH_CMD_GET_VLAN,
-	SWITCH_CMD_SET_VLAN
+	SWITCH_CMD_SET_VLAN,
+	/* events, sent to the SWITCH_MCGRP_EVENTS multicast group */
+	SWITCH_CMD_LINK_EVENT,
+	SWITCH_CMD_STATS_EVENT,
+	/* bulk operations */
+	SWITCH_CMD_SET_BULK,
+	SWITCH_CMD_GET_BULK,
 };
 
+#define SWITCH_MCGRP_EVENTS	"events"
+
 /* data types */
 enum switch_val_type {
 	SWITCH_TYPE_UNSPEC,
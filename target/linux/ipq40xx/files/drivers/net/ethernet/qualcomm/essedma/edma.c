@@ -780,91 +780,137 @@ static u16 edma_rx_complete(struct edma_common_info *edma_cinfo,
 	return erdr->pending_fill;
 }
 
+/* edma_set_rfs_filter()
+ *	Add or remove a RFS filter in the switch through the callback
+ *	registered for the address family of the flow
+ */
+static int edma_set_rfs_filter(struct edma_adapter *adapter,
+			       const struct edma_rfs_key *key, u16 rq,
+			       u32 action)
+{
+	int res = -EOPNOTSUPP;
+
+	/* Call callback registered by ESS driver */
+	if (key->family == AF_INET6) {
+		if (likely(adapter->set_rfs_rule_v6))
+			res = (*adapter->set_rfs_rule_v6)(adapter->netdev,
+				&key->src.v6, &key->dst.v6,
+				key->sport, key->dport,
+				key->proto, rq, action);
+	} else {
+		if (likely(adapter->set_rfs_rule))
+			res = (*adapter->set_rfs_rule)(adapter->netdev,
+				key->src.v4, key->dst.v4,
+				key->sport, key->dport,
+				key->proto, rq, action);
+	}
+
+	return res;
+}
+
 /* edma_delete_rfs_filter()
  *	Remove RFS filter from switch
  */
 static int edma_delete_rfs_filter(struct edma_adapter *adapter,
 				 struct edma_rfs_filter_node *filter_node)
 {
-	int res = -1;
-
-	struct flow_keys *keys = &filter_node->keys;
-
-	if (likely(adapter->set_rfs_rule))
-		res = (*adapter->set_rfs_rule)(adapter->netdev,
-			flow_get_u32_src(keys), flow_get_u32_dst(keys),
-			keys->ports.src, keys->ports.dst,
-			keys->basic.ip_proto, filter_node->rq_id, 0);
-
-	return res;
+	return edma_set_rfs_filter(adapter, &filter_node->key,
+				   filter_node->rq_id, 0);
 }
 
 /* edma_add_rfs_filter()
  *	Add RFS filter to switch
  */
 static int edma_add_rfs_filter(struct edma_adapter *adapter,
-			       struct flow_keys *keys, u16 rq,
-			       struct edma_rfs_filter_node *filter_node)
+			       const struct edma_rfs_key *key, u16 rq)
 {
-	int res = -1;
+	return edma_set_rfs_filter(adapter, key, rq, 1);
+}
 
-	struct flow_keys *dest_keys = &filter_node->keys;
+/* edma_rfs_key_fill()
+ *	Reduce dissected flow keys to the 5-tuple the switch can match
+ */
+static int edma_rfs_key_fill(struct edma_rfs_key *key,
+			     const struct flow_keys *keys)
+{
+	/* zeroed so that keys can be compared with memcmp() */
+	memset(key, 0, sizeof(*key));
+
+	switch (keys->control.addr_type) {
+	case FLOW_DISSECTOR_KEY_IPV4_ADDRS:
+		key->family = AF_INET;
+		key->src.v4 = keys->addrs.v4addrs.src;
+		key->dst.v4 = keys->addrs.v4addrs.dst;
+		break;
+	case FLOW_DISSECTOR_KEY_IPV6_ADDRS:
+		key->family = AF_INET6;
+		key->src.v6 = keys->addrs.v6addrs.src;
+		key->dst.v6 = keys->addrs.v6addrs.dst;
+		break;
+	default:
+		return -EPROTONOSUPPORT;
+	}
 
-	memcpy(dest_keys, &filter_node->keys, sizeof(*dest_keys));
-/*
-	dest_keys->control = keys->control;
-	dest_keys->basic = keys->basic;
-	dest_keys->addrs = keys->addrs;
-	dest_keys->ports = keys->ports;
-	dest_keys.ip_proto = keys->ip_proto;
-*/
-	/* Call callback registered by ESS driver */
-	if (likely(adapter->set_rfs_rule))
-		res = (*adapter->set_rfs_rule)(adapter->netdev, flow_get_u32_src(keys),
-		      flow_get_u32_dst(keys), keys->ports.src, keys->ports.dst,
-		      keys->basic.ip_proto, rq, 1);
+	key->sport = keys->ports.src;
+	key->dport = keys->ports.dst;
+	key->proto = keys->basic.ip_proto;
 
-	return res;
+	return 0;
 }
 
 /* edma_rfs_key_search()
  *	Look for existing RFS entry
  */
 static struct edma_rfs_filter_node *edma_rfs_key_search(struct hlist_head *h,
-						       struct flow_keys *key)
+						       const struct edma_rfs_key *key)
 {
 	struct edma_rfs_filter_node *p;
 
 	hlist_for_each_entry(p, h, node)
-		if (flow_get_u32_src(&p->keys) == flow_get_u32_src(key) &&
-		    flow_get_u32_dst(&p->keys) == flow_get_u32_dst(key) &&
-		    p->keys.ports.src == key->ports.src &&
-		    p->keys.ports.dst == key->ports.dst &&
-		    p->keys.basic.ip_proto == key->basic.ip_proto)
+		if (!memcmp(&p->key, key, sizeof(*key)))
 			return p;
 	return NULL;
 }
 
+/* edma_rfs_node_release()
+ *	Unhash a filter node and return it to the pool
+ */
+static void edma_rfs_node_release(struct edma_rfs_flow_table *rfs,
+				  struct edma_rfs_filter_node *filter_node)
+{
+	rfs->stats.flows[filter_node->rq_id]--;
+	rfs->filter_available++;
+	filter_node->in_use = false;
+	hlist_del(&filter_node->node);
+	hlist_add_head(&filter_node->node, &rfs->free_list);
+}
+
 /* edma_initialise_rfs_flow_table()
  * 	Initialise EDMA RFS flow table
  */
 static void edma_initialise_rfs_flow_table(struct edma_adapter *adapter)
 {
+	struct edma_rfs_flow_table *rfs = &adapter->rfs;
 	int i;
 
-	spin_lock_init(&adapter->rfs.rfs_ftab_lock);
+	spin_lock_init(&rfs->rfs_ftab_lock);
 
-	/* Initialize EDMA flow hash table */
-	for (i = 0; i < EDMA_RFS_FLOW_ENTRIES; i++)
-		INIT_HLIST_HEAD(&adapter->rfs.hlist_head[i]);
+	/* Initialize EDMA flow hash table and the preallocated nodes */
+	INIT_HLIST_HEAD(&rfs->free_list);
+	for (i = 0; i < EDMA_RFS_FLOW_ENTRIES; i++) {
+		INIT_HLIST_HEAD(&rfs->hlist_head[i]);
+		rfs->pool[i].in_use = false;
+		hlist_add_head(&rfs->pool[i].node, &rfs->free_list);
+	}
 
-	adapter->rfs.max_num_filter = EDMA_RFS_FLOW_ENTRIES;
-	adapter->rfs.filter_available = adapter->rfs.max_num_filter;
-	adapter->rfs.hashtoclean = 0;
+	memset(rfs->stats.flows, 0, sizeof(rfs->stats.flows));
+	rfs->max_num_filter = EDMA_RFS_FLOW_ENTRIES;
+	rfs->filter_available = rfs->max_num_filter;
+	rfs->expire_next = 0;
 
-	/* Add timer to get periodic RFS updates from OS */
-	timer_setup(&adapter->rfs.expire_rfs, edma_flow_may_expire, 0);
-	mod_timer(&adapter->rfs.expire_rfs, jiffies + HZ / 4);
+	/* The expiry timer is armed once the first flow gets steered */
+	timer_setup(&rfs->expire_rfs, edma_flow_may_expire, 0);
+	rfs->enabled = true;
 }
 
 /* edma_free_rfs_flow_table()
@@ -872,34 +918,36 @@ static void edma_initialise_rfs_flow_table(struct edma_adapter *adapter)
  */
 static void edma_free_rfs_flow_table(struct edma_adapter *adapter)
 {
+	struct edma_rfs_flow_table *rfs = &adapter->rfs;
 	int i;
 
-	/* Remove sync timer */
-	del_timer_sync(&adapter->rfs.expire_rfs);
-	spin_lock_bh(&adapter->rfs.rfs_ftab_lock);
+	/* Keep the timer from being re-armed, then remove it */
+	spin_lock_bh(&rfs->rfs_ftab_lock);
+	rfs->enabled = false;
+	spin_unlock_bh(&rfs->rfs_ftab_lock);
+	del_timer_sync(&rfs->expire_rfs);
 
-	/* Free EDMA RFS table entries */
-	adapter->rfs.filter_available = 0;
+	spin_lock_bh(&rfs->rfs_ftab_lock);
 
 	/* Clean-up EDMA flow hash table */
 	for (i = 0; i < EDMA_RFS_FLOW_ENTRIES; i++) {
-		struct hlist_head *hhead;
-		struct hlist_node *tmp;
-		struct edma_rfs_filter_node *filter_node;
+		struct edma_rfs_filter_node *filter_node = &rfs->pool[i];
 		int res;
 
-		hhead = &adapter->rfs.hlist_head[i];
-		hlist_for_each_entry_safe(filter_node, tmp, hhead, node) {
-			res  = edma_delete_rfs_filter(adapter, filter_node);
-			if (res < 0)
-				dev_warn(&adapter->netdev->dev,
-					"EDMA going down but RFS entry %d not allowed to be flushed by Switch",
-				        filter_node->flow_id);
-			hlist_del(&filter_node->node);
-			kfree(filter_node);
-		}
+		if (!filter_node->in_use)
+			continue;
+
+		res = edma_delete_rfs_filter(adapter, filter_node);
+		if (res < 0)
+			dev_warn(&adapter->netdev->dev,
+				"EDMA going down but RFS entry %d not allowed to be flushed by Switch",
+			        filter_node->flow_id);
+		edma_rfs_node_release(rfs, filter_node);
 	}
-	spin_unlock_bh(&adapter->rfs.rfs_ftab_lock);
+
+	/* Free EDMA RFS table entries */
+	rfs->filter_available = 0;
+	spin_unlock_bh(&rfs->rfs_ftab_lock);
 }
 
 /* edma_tx_unmap_and_free()
@@ -1448,38 +1496,39 @@ void edma_flow_may_expire(struct timer_list *t)
 	struct edma_rfs_flow_table *table = from_timer(table, t, expire_rfs);
 	struct edma_adapter *adapter =
 		container_of(table, typeof(*adapter), rfs);
+	struct edma_rfs_flow_table *rfs = &adapter->rfs;
 	int j;
 
-	spin_lock_bh(&adapter->rfs.rfs_ftab_lock);
+	/* Check a batch of the pool per run, unused nodes are skipped */
+	spin_lock_bh(&rfs->rfs_ftab_lock);
 	for (j = 0; j < EDMA_RFS_EXPIRE_COUNT_PER_CALL; j++) {
-		struct hlist_head *hhead;
-		struct hlist_node *tmp;
-		struct edma_rfs_filter_node *n;
+		struct edma_rfs_filter_node *n = &rfs->pool[rfs->expire_next++];
 		bool res;
 
-		hhead = &adapter->rfs.hlist_head[adapter->rfs.hashtoclean++];
-		hlist_for_each_entry_safe(n, tmp, hhead, node) {
-			res = rps_may_expire_flow(adapter->netdev, n->rq_id,
-					n->flow_id, n->filter_id);
-			if (res) {
-				int ret;
-				ret = edma_delete_rfs_filter(adapter, n);
-				if (ret < 0)
-					dev_dbg(&adapter->netdev->dev,
-							"RFS entry %d not allowed to be flushed by Switch",
-							n->flow_id);
-				else {
-					hlist_del(&n->node);
-					kfree(n);
-					adapter->rfs.filter_available++;
-				}
+		rfs->expire_next &= EDMA_RFS_FLOW_ENTRIES_MASK;
+		if (!n->in_use)
+			continue;
+
+		res = rps_may_expire_flow(adapter->netdev, n->rq_id,
+				n->flow_id, n->filter_id);
+		if (res) {
+			int ret;
+			ret = edma_delete_rfs_filter(adapter, n);
+			if (ret < 0)
+				dev_dbg(&adapter->netdev->dev,
+						"RFS entry %d not allowed to be flushed by Switch",
+						n->flow_id);
+			else {
+				edma_rfs_node_release(rfs, n);
+				rfs->stats.expired++;
 			}
 		}
 	}
 
-	adapter->rfs.hashtoclean = adapter->rfs.hashtoclean & (EDMA_RFS_FLOW_ENTRIES - 1);
-	spin_unlock_bh(&adapter->rfs.rfs_ftab_lock);
-	mod_timer(&adapter->rfs.expire_rfs, jiffies + HZ / 4);
+	/* Stay idle while no flow is steered */
+	if (rfs->enabled && rfs->filter_available < rfs->max_num_filter)
+		mod_timer(&rfs->expire_rfs, jiffies + HZ / 4);
+	spin_unlock_bh(&rfs->rfs_ftab_lock);
 }
 
 /* edma_rx_flow_steer()
@@ -1489,22 +1538,23 @@ int edma_rx_flow_steer(struct net_device *dev, const struct sk_buff *skb,
 		       u16 rxq, u32 flow_id)
 {
 	struct flow_keys keys;
+	struct edma_rfs_key key;
 	struct edma_rfs_filter_node *filter_node;
 	struct edma_adapter *adapter = netdev_priv(dev);
+	struct edma_rfs_flow_table *rfs = &adapter->rfs;
 	u16 hash_tblid;
 	int res;
 
-	if (skb->protocol == htons(ETH_P_IPV6)) {
-		dev_err(&adapter->pdev->dev, "IPv6 not supported\n");
-		res = -EINVAL;
-		goto no_protocol_err;
-	}
+	if (rxq >= EDMA_NETDEV_RX_QUEUE)
+		return -EINVAL;
 
 	/* Dissect flow parameters
-	 * We only support IPv4 + TCP/UDP
+	 * We only support IPv4/IPv6 + TCP/UDP
 	 */
-	res = skb_flow_dissect_flow_keys(skb, &keys, 0);
-	if (!((keys.basic.ip_proto == IPPROTO_TCP) || (keys.basic.ip_proto == IPPROTO_UDP))) {
+	if (!skb_flow_dissect_flow_keys(skb, &keys, 0) ||
+	    !((keys.basic.ip_proto == IPPROTO_TCP) || (keys.basic.ip_proto == IPPROTO_UDP)) ||
+	    edma_rfs_key_fill(&key, &keys) ||
+	    (key.family == AF_INET6 && !adapter->set_rfs_rule_v6)) {
 		res = -EPROTONOSUPPORT;
 		goto no_protocol_err;
 	}
@@ -1512,8 +1562,13 @@ int edma_rx_flow_steer(struct net_device *dev, const struct sk_buff *skb,
 	/* Check if table entry exists */
 	hash_tblid = skb_get_hash_raw(skb) & EDMA_RFS_FLOW_ENTRIES_MASK;
 
-	spin_lock_bh(&adapter->rfs.rfs_ftab_lock);
-	filter_node = edma_rfs_key_search(&adapter->rfs.hlist_head[hash_tblid], &keys);
+	spin_lock_bh(&rfs->rfs_ftab_lock);
+	if (!rfs->enabled) {
+		res = -ENODEV;
+		goto out;
+	}
+
+	filter_node = edma_rfs_key_search(&rfs->hlist_head[hash_tblid], &key);
 
 	if (filter_node) {
 		if (rxq == filter_node->rq_id) {
@@ -1526,49 +1581,61 @@ int edma_rx_flow_steer(struct net_device *dev, const struct sk_buff *skb,
 						"Cannot steer flow %d to different queue",
 						filter_node->flow_id);
 			else {
-				adapter->rfs.filter_available++;
-				res = edma_add_rfs_filter(adapter, &keys, rxq, filter_node);
+				res = edma_add_rfs_filter(adapter, &key, rxq);
 				if (res < 0) {
 					dev_warn(&adapter->netdev->dev,
 							"Cannot steer flow %d to different queue",
 							filter_node->flow_id);
+					edma_rfs_node_release(rfs, filter_node);
+					rfs->stats.hw_fail++;
 				} else {
-					adapter->rfs.filter_available--;
+					rfs->stats.flows[filter_node->rq_id]--;
+					rfs->stats.flows[rxq]++;
+					rfs->stats.steered[rxq]++;
 					filter_node->rq_id = rxq;
 					filter_node->filter_id = res;
 				}
 			}
 		}
 	} else {
-		if (adapter->rfs.filter_available == 0) {
+		if (hlist_empty(&rfs->free_list)) {
+			rfs->stats.no_room++;
 			res = -EBUSY;
 			goto out;
 		}
 
-		filter_node = kmalloc(sizeof(*filter_node), GFP_ATOMIC);
-		if (!filter_node) {
-			res = -ENOMEM;
-			goto out;
-		}
-
-		res = edma_add_rfs_filter(adapter, &keys, rxq, filter_node);
+		res = edma_add_rfs_filter(adapter, &key, rxq);
 		if (res < 0) {
-			kfree(filter_node);
+			rfs->stats.hw_fail++;
 			goto out;
 		}
 
-		adapter->rfs.filter_available--;
+		filter_node = hlist_entry(rfs->free_list.first,
+					  struct edma_rfs_filter_node, node);
+		hlist_del(&filter_node->node);
+
+		rfs->filter_available--;
+		rfs->stats.flows[rxq]++;
+		rfs->stats.steered[rxq]++;
 		filter_node->rq_id = rxq;
 		filter_node->filter_id = res;
 		filter_node->flow_id = flow_id;
-		filter_node->keys = keys;
-		INIT_HLIST_NODE(&filter_node->node);
-		hlist_add_head(&filter_node->node, &adapter->rfs.hlist_head[hash_tblid]);
+		filter_node->key = key;
+		filter_node->in_use = true;
+		hlist_add_head(&filter_node->node, &rfs->hlist_head[hash_tblid]);
+
+		if (!timer_pending(&rfs->expire_rfs))
+			mod_timer(&rfs->expire_rfs, jiffies + HZ / 4);
 	}
 
 out:
-	spin_unlock_bh(&adapter->rfs.rfs_ftab_lock);
+	spin_unlock_bh(&rfs->rfs_ftab_lock);
+	return res;
+
 no_protocol_err:
+	spin_lock_bh(&rfs->rfs_ftab_lock);
+	rfs->stats.unsupported++;
+	spin_unlock_bh(&rfs->rfs_ftab_lock);
 	return res;
 }
 
@@ -1593,6 +1660,27 @@ int edma_register_rfs_filter(struct net_device *netdev,
 	return 0;
 }
 
+/* edma_register_rfs_filter_v6()
+ *	Add IPv6 RFS filter callback
+ */
+int edma_register_rfs_filter_v6(struct net_device *netdev,
+			       set_rfs_filter_v6_callback_t set_filter)
+{
+	struct edma_adapter *adapter = netdev_priv(netdev);
+
+	spin_lock_bh(&adapter->rfs.rfs_ftab_lock);
+
+	if (adapter->set_rfs_rule_v6) {
+		spin_unlock_bh(&adapter->rfs.rfs_ftab_lock);
+		return -1;
+	}
+
+	adapter->set_rfs_rule_v6 = set_filter;
+	spin_unlock_bh(&adapter->rfs.rfs_ftab_lock);
+
+	return 0;
+}
+
 /* edma_alloc_tx_rings()
  *	Allocate rx rings
  */
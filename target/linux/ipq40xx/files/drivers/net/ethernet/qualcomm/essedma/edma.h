@@ -366,21 +366,48 @@ struct edma_rfd_desc_ring {
 	u16 pending_fill; /* fill pending from previous iteration */
 };
 
+/* edma_rfs_key - 5-tuple of a steered IPv4 or IPv6 flow */
+struct edma_rfs_key {
+	union {
+		__be32 v4;
+		struct in6_addr v6;
+	} src, dst;
+	__be16 sport;
+	__be16 dport;
+	u8 proto;
+	u8 family; /* AF_INET or AF_INET6 */
+};
+
 /* edma_rfs_flter_node - rfs filter node in hash table */
 struct edma_rfs_filter_node {
-	struct flow_keys keys;
+	struct edma_rfs_key key;
 	u32 flow_id; /* flow_id of filter provided by kernel */
 	u16 filter_id; /* filter id of filter returned by adaptor */
 	u16 rq_id; /* desired rq index */
+	bool in_use; /* node is hashed, not on the free list */
 	struct hlist_node node; /* edma rfs list node */
 };
 
+/* edma_rfs_stats - rfs steering statistics, rx queue n is serviced by CPU n */
+struct edma_rfs_stats {
+	u32 flows[EDMA_NETDEV_RX_QUEUE]; /* filters currently steering to CPU */
+	u32 steered[EDMA_NETDEV_RX_QUEUE]; /* filters ever steered to CPU */
+	u32 expired; /* filters removed by edma_flow_may_expire */
+	u32 no_room; /* flows not steered as the table was full */
+	u32 hw_fail; /* flows the switch refused to add */
+	u32 unsupported; /* flows without a usable protocol or callback */
+};
+
 /* edma_rfs_flow_tbl - rfs flow table */
 struct edma_rfs_flow_table {
 	u16 max_num_filter; /* Maximum number of filters edma supports */
-	u16 hashtoclean; /* hash table index to clean next */
+	u16 expire_next; /* pool index to check for expiry next */
 	int filter_available; /* Number of free filters available */
+	bool enabled; /* table is set up, expiry timer may be armed */
 	struct hlist_head hlist_head[EDMA_RFS_FLOW_ENTRIES];
+	struct hlist_head free_list; /* unused nodes of the pool */
+	struct edma_rfs_filter_node pool[EDMA_RFS_FLOW_ENTRIES];
+	struct edma_rfs_stats stats;
 	spinlock_t rfs_ftab_lock;
 	struct timer_list expire_rfs; /* timer function for edma_rps_may_expire_flow */
 };
@@ -394,6 +421,7 @@ struct edma_adapter {
 	struct edma_rfs_flow_table rfs; /* edma rfs flow table */
 	struct net_device_stats stats; /* netdev statistics */
 	set_rfs_filter_callback_t set_rfs_rule;
+	set_rfs_filter_v6_callback_t set_rfs_rule_v6;
 	u32 flags;/* status flags */
 	unsigned long state_flags; /* GMAC up/down flags */
 	u32 forced_speed; /* link force speed */
@@ -438,6 +466,8 @@ int edma_rx_flow_steer(struct net_device *dev, const struct sk_buff *skb,
 		u16 rxq, u32 flow_id);
 int edma_register_rfs_filter(struct net_device *netdev,
 		set_rfs_filter_callback_t set_filter);
+int edma_register_rfs_filter_v6(struct net_device *netdev,
+		set_rfs_filter_v6_callback_t set_filter);
 void edma_flow_may_expire(struct timer_list *t);
 void edma_set_ethtool_ops(struct net_device *netdev);
 void edma_set_stp_rstp(bool tag);
@@ -83,6 +83,27 @@ static const struct edma_ethtool_stats edma_gstrings_stats[] = {
 
 #define EDMA_STATS_LEN ARRAY_SIZE(edma_gstrings_stats)
 
+#define EDMA_RFS_STAT(m)    offsetof(struct edma_rfs_stats, m)
+
+/* Array of strings describing per netdev RFS statistics
+ */
+static const struct edma_ethtool_stats edma_gstrings_rfs_stats[] = {
+	{"rfs_cpu0_flows", EDMA_RFS_STAT(flows[0])},
+	{"rfs_cpu1_flows", EDMA_RFS_STAT(flows[1])},
+	{"rfs_cpu2_flows", EDMA_RFS_STAT(flows[2])},
+	{"rfs_cpu3_flows", EDMA_RFS_STAT(flows[3])},
+	{"rfs_cpu0_steered", EDMA_RFS_STAT(steered[0])},
+	{"rfs_cpu1_steered", EDMA_RFS_STAT(steered[1])},
+	{"rfs_cpu2_steered", EDMA_RFS_STAT(steered[2])},
+	{"rfs_cpu3_steered", EDMA_RFS_STAT(steered[3])},
+	{"rfs_expired", EDMA_RFS_STAT(expired)},
+	{"rfs_no_room", EDMA_RFS_STAT(no_room)},
+	{"rfs_hw_fail", EDMA_RFS_STAT(hw_fail)},
+	{"rfs_unsupported", EDMA_RFS_STAT(unsupported)},
+};
+
+#define EDMA_RFS_STATS_LEN ARRAY_SIZE(edma_gstrings_rfs_stats)
+
 /* edma_get_strset_count()
  *	Get strset count
  */
@@ -91,7 +112,7 @@ static int edma_get_strset_count(struct net_device *netdev,
 {
 	switch (sset) {
 	case ETH_SS_STATS:
-		return EDMA_STATS_LEN;
+		return EDMA_STATS_LEN + EDMA_RFS_STATS_LEN;
 	default:
 		netdev_dbg(netdev, "%s: Invalid string set", __func__);
 		return -EOPNOTSUPP;
@@ -117,6 +138,13 @@ static void edma_get_strings(struct net_device *netdev, uint32_t stringset,
 				    + 1));
 			p += ETH_GSTRING_LEN;
 		}
+		for (i = 0; i < EDMA_RFS_STATS_LEN; i++) {
+			memcpy(p, edma_gstrings_rfs_stats[i].stat_string,
+				min((size_t)ETH_GSTRING_LEN,
+				    strlen(edma_gstrings_rfs_stats[i].stat_string)
+				    + 1));
+			p += ETH_GSTRING_LEN;
+		}
 		break;
 	}
 }
@@ -139,6 +167,12 @@ static void edma_get_ethtool_stats(struct net_device *netdev,
 			edma_gstrings_stats[i].stat_offset;
 		data[i] = *(uint32_t *)p;
 	}
+
+	for (i = 0; i < EDMA_RFS_STATS_LEN; i++) {
+		p = (uint8_t *)&adapter->rfs.stats +
+			edma_gstrings_rfs_stats[i].stat_offset;
+		data[EDMA_STATS_LEN + i] = *(uint32_t *)p;
+	}
 }
 
 /* edma_get_drvinfo()
@@ -23,6 +23,7 @@
 #include <linux/reset.h>
 #include <linux/lockdep.h>
 #include <linux/workqueue.h>
+#include <linux/interrupt.h>
 #include <linux/of_device.h>
 #include <linux/of_address.h>
 #include <linux/of_mdio.h>
@@ -1284,56 +1285,59 @@ int ar40xx_force_1g_full(struct ar40xx_priv *priv, u32 port_id)
 			(AR40XX_PORT_SPEED_1000M | AR40XX_PORT_DUPLEX));
 }
 
-static
-int ar40xx_get_qm_status(struct ar40xx_priv *priv,
-			 u32 port_id, u32 *qm_buffer_err)
+/* read the queue buffer state of all ports with two register reads */
+static void
+ar40xx_get_qm_status(struct ar40xx_priv *priv, u32 *qm_buffer_err)
 {
-	u32 reg;
 	u32 qm_val;
+	int i;
 
-	if (port_id < 1 || port_id > 5) {
-		*qm_buffer_err = 0;
-		return -1;
-	}
-
-	if (port_id < 4) {
-		reg = AR40XX_REG_QM_PORT0_3_QNUM;
-		ar40xx_write(priv, AR40XX_REG_QM_DEBUG_ADDR, reg);
-		qm_val = ar40xx_read(priv, AR40XX_REG_QM_DEBUG_VALUE);
-		/* every 8 bits for each port */
-		*qm_buffer_err = (qm_val >> (port_id * 8)) & 0xFF;
-	} else {
-		reg = AR40XX_REG_QM_PORT4_6_QNUM;
-		ar40xx_write(priv, AR40XX_REG_QM_DEBUG_ADDR, reg);
-		qm_val = ar40xx_read(priv, AR40XX_REG_QM_DEBUG_VALUE);
-		/* every 8 bits for each port */
-		*qm_buffer_err = (qm_val >> ((port_id-4) * 8)) & 0xFF;
-	}
+	ar40xx_write(priv, AR40XX_REG_QM_DEBUG_ADDR,
+		     AR40XX_REG_QM_PORT0_3_QNUM);
+	qm_val = ar40xx_read(priv, AR40XX_REG_QM_DEBUG_VALUE);
+	/* every 8 bits for each port */
+	for (i = 1; i < 4; i++)
+		qm_buffer_err[i] = (qm_val >> (i * 8)) & 0xFF;
 
-	return 0;
+	ar40xx_write(priv, AR40XX_REG_QM_DEBUG_ADDR,
+		     AR40XX_REG_QM_PORT4_6_QNUM);
+	qm_val = ar40xx_read(priv, AR40XX_REG_QM_DEBUG_VALUE);
+	for (i = 4; i < AR40XX_NUM_PORTS; i++)
+		qm_buffer_err[i] = (qm_val >> ((i - 4) * 8)) & 0xFF;
 }
 
-static void
+/*
+ * Returns true if a link changed or a transition is still in progress,
+ * so that the caller checks again soon.
+ */
+static bool
 ar40xx_sw_mac_polling_task(struct ar40xx_priv *priv)
 {
-	static int task_count;
 	u32 i;
 	u32 reg, value;
 	u32 link, speed, duplex;
-	u32 qm_buffer_err;
+	u32 qm_buffer_err[AR40XX_NUM_PORTS];
 	u16 port_phy_status[AR40XX_NUM_PORTS];
-	static u32 qm_err_cnt[AR40XX_NUM_PORTS] = {0, 0, 0, 0, 0, 0};
-	static u32 link_cnt[AR40XX_NUM_PORTS] = {0, 0, 0, 0, 0, 0};
+	unsigned long dirty;
+	u32 link_down = 0;
+	u32 qm_ports = 0;
+	bool busy = false;
 	struct mii_bus *bus = NULL;
 
 	if (!priv || !priv->mii_bus)
-		return;
+		return false;
 
 	bus = priv->mii_bus;
 
-	++task_count;
+	/* ports with a PHY interrupt are only read once it fired */
+	dirty = xchg(&priv->link_dirty, 0);
+	dirty |= GENMASK(AR40XX_NUM_PORTS - 1, 1) & ~priv->phy_irq_ports;
 
 	for (i = 1; i < AR40XX_NUM_PORTS; ++i) {
+		/* a link up is only acted upon after a second read */
+		if (!(dirty & BIT(i)) && !priv->port_link_up[i])
+			continue;
+
 		port_phy_status[i] =
 			mdiobus_read(bus, i-1, AR40XX_PHY_SPEC_STATUS);
 		speed = link = duplex = port_phy_status[i];
@@ -1345,7 +1349,8 @@ ar40xx_sw_mac_polling_task(struct ar40xx_priv *priv)
 		duplex >>= 13;
 
 		if (link != priv->ar40xx_port_old_link[i]) {
-			++link_cnt[i];
+			++priv->link_cnt[i];
+			busy = true;
 			/* Up --> Down */
 			if ((priv->ar40xx_port_old_link[i] ==
 					AR40XX_PORT_LINK_UP) &&
@@ -1355,32 +1360,10 @@ ar40xx_sw_mac_polling_task(struct ar40xx_priv *priv)
 				ar40xx_rmw(priv, reg,
 						AR40XX_PORT_AUTO_LINK_EN, 0);
 
-				/* Check queue buffer */
-				qm_err_cnt[i] = 0;
-				ar40xx_get_qm_status(priv, i, &qm_buffer_err);
-				if (qm_buffer_err) {
-					priv->ar40xx_port_qm_buf[i] =
-						AR40XX_QM_NOT_EMPTY;
-				} else {
-					u16 phy_val = 0;
-
-					priv->ar40xx_port_qm_buf[i] =
-						AR40XX_QM_EMPTY;
-					ar40xx_force_1g_full(priv, i);
-					/* Ref:QCA8337 Datasheet,Clearing
-					 * MENU_CTRL_EN prevents phy to
-					 * stuck in 100BT mode when
-					 * bringing up the link
-					 */
-					ar40xx_phy_dbg_read(priv, i-1,
-							    AR40XX_PHY_DEBUG_0,
-							    &phy_val);
-					phy_val &= (~AR40XX_PHY_MANU_CTRL_EN);
-					ar40xx_phy_dbg_write(priv, i-1,
-							     AR40XX_PHY_DEBUG_0,
-							     phy_val);
-				}
+				/* queue buffer is checked below */
+				link_down |= BIT(i);
 				priv->ar40xx_port_old_link[i] = link;
+				switch_port_link_changed(&priv->dev, i);
 			} else if ((priv->ar40xx_port_old_link[i] ==
 						AR40XX_PORT_LINK_DOWN) &&
 					(link == AR40XX_PORT_LINK_UP)) {
@@ -1424,39 +1407,104 @@ ar40xx_sw_mac_polling_task(struct ar40xx_priv *priv)
 								     phy_val);
 					}
 					priv->ar40xx_port_old_link[i] = link;
+					switch_port_link_changed(&priv->dev, i);
 				}
 			}
+		} else {
+			/* link went back down before it was confirmed */
+			priv->port_link_up[i] = 0;
+		}
+
+		if (priv->port_link_up[i])
+			busy = true;
+	}
+
+	for (i = 1; i < AR40XX_NUM_PORTS; ++i)
+		if ((link_down & BIT(i)) ||
+		    priv->ar40xx_port_qm_buf[i] == AR40XX_QM_NOT_EMPTY)
+			qm_ports |= BIT(i);
+
+	if (!qm_ports)
+		return busy;
+
+	/* Check queue buffers of all affected ports at once */
+	ar40xx_get_qm_status(priv, qm_buffer_err);
+
+	for (i = 1; i < AR40XX_NUM_PORTS; ++i) {
+		if (!(qm_ports & BIT(i)))
+			continue;
+
+		if (link_down & BIT(i)) {
+			priv->qm_err_cnt[i] = 0;
+			if (qm_buffer_err[i]) {
+				priv->ar40xx_port_qm_buf[i] =
+					AR40XX_QM_NOT_EMPTY;
+			} else {
+				u16 phy_val = 0;
+
+				priv->ar40xx_port_qm_buf[i] =
+					AR40XX_QM_EMPTY;
+				ar40xx_force_1g_full(priv, i);
+				/* Ref:QCA8337 Datasheet,Clearing
+				 * MENU_CTRL_EN prevents phy to
+				 * stuck in 100BT mode when
+				 * bringing up the link
+				 */
+				ar40xx_phy_dbg_read(priv, i-1,
+						    AR40XX_PHY_DEBUG_0,
+						    &phy_val);
+				phy_val &= (~AR40XX_PHY_MANU_CTRL_EN);
+				ar40xx_phy_dbg_write(priv, i-1,
+						     AR40XX_PHY_DEBUG_0,
+						     phy_val);
+			}
 		}
 
 		if (priv->ar40xx_port_qm_buf[i] == AR40XX_QM_NOT_EMPTY) {
 			/* Check QM */
-			ar40xx_get_qm_status(priv, i, &qm_buffer_err);
-			if (qm_buffer_err) {
-				++qm_err_cnt[i];
+			if (qm_buffer_err[i]) {
+				++priv->qm_err_cnt[i];
+				busy = true;
 			} else {
 				priv->ar40xx_port_qm_buf[i] =
 						AR40XX_QM_EMPTY;
-				qm_err_cnt[i] = 0;
+				priv->qm_err_cnt[i] = 0;
 				ar40xx_force_1g_full(priv, i);
 			}
 		}
 	}
+
+	return busy;
 }
 
+/*
+ * Polls at AR40XX_QM_WORK_DELAY while links change or queues drain, and
+ * backs off up to AR40XX_QM_WORK_DELAY_MAX while idle. Once every PHY
+ * has its interrupt wired, idle polling stops completely.
+ */
 static void
 ar40xx_qm_err_check_work_task(struct work_struct *work)
 {
 	struct ar40xx_priv *priv = container_of(work, struct ar40xx_priv,
 					qm_dwork.work);
+	unsigned long delay = msecs_to_jiffies(AR40XX_QM_WORK_DELAY);
+	unsigned long delay_max = msecs_to_jiffies(AR40XX_QM_WORK_DELAY_MAX);
+	bool busy;
 
 	mutex_lock(&priv->qm_lock);
 
-	ar40xx_sw_mac_polling_task(priv);
+	busy = ar40xx_sw_mac_polling_task(priv);
 
 	mutex_unlock(&priv->qm_lock);
 
-	schedule_delayed_work(&priv->qm_dwork,
-			      msecs_to_jiffies(AR40XX_QM_WORK_DELAY));
+	if (busy)
+		priv->qm_interval = delay;
+	else if (priv->dev.link_notify)
+		return;
+	else
+		priv->qm_interval = min(priv->qm_interval * 2, delay_max);
+
+	schedule_delayed_work(&priv->qm_dwork, priv->qm_interval);
 }
 
 static int
@@ -1466,12 +1514,118 @@ ar40xx_qm_err_check_work_start(struct ar40xx_priv *priv)
 
 	INIT_DELAYED_WORK(&priv->qm_dwork, ar40xx_qm_err_check_work_task);
 
-	schedule_delayed_work(&priv->qm_dwork,
-			      msecs_to_jiffies(AR40XX_QM_WORK_DELAY));
+	priv->qm_interval = msecs_to_jiffies(AR40XX_QM_WORK_DELAY);
+	schedule_delayed_work(&priv->qm_dwork, priv->qm_interval);
 
 	return 0;
 }
 
+static irqreturn_t
+ar40xx_phy_irq(int irq, void *dev_id)
+{
+	struct ar40xx_priv *priv = dev_id;
+	bool pending = false;
+	int status;
+	int i;
+
+	for (i = 1; i < AR40XX_NUM_PORTS; i++) {
+		if (priv->phy_irq[i] != irq)
+			continue;
+
+		/* reading the status acks the interrupt */
+		status = mdiobus_read(priv->mii_bus, i - 1,
+				      AR40XX_PHY_INT_STATUS);
+		if (status > 0 && (status & AR40XX_PHY_INT_LINK_MASK)) {
+			set_bit(i, &priv->link_dirty);
+			pending = true;
+		}
+	}
+
+	if (!pending)
+		return IRQ_NONE;
+
+	mod_delayed_work(system_wq, &priv->qm_dwork, 0);
+
+	return IRQ_HANDLED;
+}
+
+static void
+ar40xx_phy_irq_init(struct ar40xx_priv *priv, struct device *dev)
+{
+	struct mii_bus *bus = priv->mii_bus;
+	struct phy_device *phydev;
+	int i, j, irq, ret;
+
+	for (i = 1; i < AR40XX_NUM_PORTS; i++) {
+		phydev = mdiobus_get_phy(bus, i - 1);
+		if (!phydev || !phy_interrupt_is_valid(phydev))
+			continue;
+
+		irq = phydev->irq;
+
+		/* the PHYs of one package usually share the line */
+		for (j = 1; j < i; j++)
+			if (priv->phy_irq[j] == irq)
+				break;
+
+		priv->phy_irq[i] = irq;
+		if (j == i) {
+			ret = request_threaded_irq(irq, NULL, ar40xx_phy_irq,
+						   IRQF_ONESHOT | IRQF_SHARED,
+						   dev_name(dev), priv);
+			if (ret) {
+				dev_warn(dev, "failed to request PHY irq %d, polling port %d\n",
+					 irq, i);
+				priv->phy_irq[i] = 0;
+				continue;
+			}
+		}
+
+		priv->phy_irq_ports |= BIT(i);
+		/* pick up a link which came up before the interrupt */
+		set_bit(i, &priv->link_dirty);
+		mdiobus_read(bus, i - 1, AR40XX_PHY_INT_STATUS);
+		mdiobus_write(bus, i - 1, AR40XX_PHY_INT_MASK,
+			      AR40XX_PHY_INT_LINK_MASK);
+	}
+
+	if (!priv->phy_irq_ports)
+		return;
+
+	priv->dev.link_notify =
+		priv->phy_irq_ports == GENMASK(AR40XX_NUM_PORTS - 1, 1);
+	mod_delayed_work(system_wq, &priv->qm_dwork, 0);
+}
+
+static void
+ar40xx_phy_irq_exit(struct ar40xx_priv *priv)
+{
+	int i, j;
+
+	for (i = 1; i < AR40XX_NUM_PORTS; i++) {
+		if (!(priv->phy_irq_ports & BIT(i)))
+			continue;
+
+		mdiobus_write(priv->mii_bus, i - 1, AR40XX_PHY_INT_MASK, 0);
+	}
+
+	for (i = 1; i < AR40XX_NUM_PORTS; i++) {
+		if (!(priv->phy_irq_ports & BIT(i)))
+			continue;
+
+		for (j = 1; j < i; j++)
+			if ((priv->phy_irq_ports & BIT(j)) &&
+			    priv->phy_irq[j] == priv->phy_irq[i])
+				break;
+
+		if (j == i)
+			free_irq(priv->phy_irq[i], priv);
+	}
+
+	priv->phy_irq_ports = 0;
+	priv->dev.link_notify = false;
+}
+
 /* End of qm error WAR */
 
 static int
@@ -1848,6 +2002,7 @@ static int ar40xx_probe(struct platform_device *pdev)
 	}
 
 	ar40xx_start(priv);
+	ar40xx_phy_irq_init(priv, &pdev->dev);
 
 	return 0;
 
@@ -1862,6 +2017,7 @@ static int ar40xx_remove(struct platform_device *pdev)
 {
 	struct ar40xx_priv *priv = platform_get_drvdata(pdev);
 
+	ar40xx_phy_irq_exit(priv);
 	cancel_delayed_work_sync(&priv->qm_dwork);
 	cancel_delayed_work_sync(&priv->mib_work);
 
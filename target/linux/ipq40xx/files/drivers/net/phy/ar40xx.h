@@ -39,9 +39,17 @@ struct ar40xx_priv {
 	/* mutex for qm task */
 	struct mutex qm_lock;
 	struct delayed_work qm_dwork;
+	unsigned long qm_interval;
 	u32 port_link_up[AR40XX_NUM_PORTS];
 	u32 ar40xx_port_old_link[AR40XX_NUM_PORTS];
 	u32 ar40xx_port_qm_buf[AR40XX_NUM_PORTS];
+	u32 qm_err_cnt[AR40XX_NUM_PORTS];
+	u32 link_cnt[AR40XX_NUM_PORTS];
+
+	/* ports with a wired PHY interrupt, and the ones it reported */
+	u32 phy_irq_ports;
+	int phy_irq[AR40XX_NUM_PORTS];
+	unsigned long link_dirty;
 
 	u32 phy_t_status;
 
@@ -278,6 +286,17 @@ struct ar40xx_mib_desc {
 #define   AR40XX_PHY_SPEC_STATUS_DUPLEX		BIT(13)
 #define   AR40XX_PHY_SPEC_STATUS_SPEED		BITS(14, 2)
 
+#define AR40XX_PHY_INT_MASK 0x12
+#define AR40XX_PHY_INT_STATUS 0x13
+#define   AR40XX_PHY_INT_SPEED_CHANGE		BIT(14)
+#define   AR40XX_PHY_INT_DUPLEX_CHANGE		BIT(13)
+#define   AR40XX_PHY_INT_LINK_FAIL		BIT(11)
+#define   AR40XX_PHY_INT_LINK_SUCCESS		BIT(10)
+#define   AR40XX_PHY_INT_LINK_MASK		(AR40XX_PHY_INT_SPEED_CHANGE | \
+						 AR40XX_PHY_INT_DUPLEX_CHANGE | \
+						 AR40XX_PHY_INT_LINK_FAIL | \
+						 AR40XX_PHY_INT_LINK_SUCCESS)
+
 /* port forwarding state */
 enum {
 	AR40XX_PORT_STATE_DISABLED = 0,
@@ -313,6 +332,7 @@ enum {
 #define AR40XX_MIB_WORK_DELAY	2000 /* msecs */
 
 #define AR40XX_QM_WORK_DELAY    100
+#define AR40XX_QM_WORK_DELAY_MAX	1000 /* msecs */
 
 #define   AR40XX_MIB_FUNC_CAPTURE	0x3
 
@@ -78,9 +78,16 @@ enum {
 	/** The different Oxsemi SATA core version numbers */
 	SATA_OXNAS_CORE_VERSION = 0x1f3,
 	SATA_OXNAS_IRQ_FLAG	= IRQF_SHARED,
+	/* No NCQ: the ORB registers and the per-port SGDMA channel only
+	 * ever track a single outstanding command
+	 */
 	SATA_OXNAS_HOST_FLAGS	= (ATA_FLAG_SATA | ATA_FLAG_PIO_DMA |
 			ATA_FLAG_NO_ATAPI /*| ATA_FLAG_NCQ*/),
 	SATA_OXNAS_QUEUE_DEPTH	= 32,
+	/** Commands a port may run while holding the core and the other
+	 * port is waiting for it
+	 */
+	SATA_OXNAS_CORE_BATCH	= 8,
 
 	SATA_OXNAS_DMA_BOUNDARY = 0xFFFFFFFF,
 };
@@ -392,6 +399,10 @@ struct sata_oxnas_host_priv {
 	void *locker_uid;
 	int current_locker_type;
 	int scsi_nonblocking_attempts;
+	int core_batch;
+	u32 port_waiting;
+	int handoff_port_no;
+	unsigned long handoff_expires;
 	oxnas_sata_isr_callback_t isr_callback;
 	void *isr_arg;
 	wait_queue_head_t fast_wait_queue;
@@ -421,6 +432,9 @@ static void sata_oxnas_release_hw(struct ata_port *ap);
 
 static const void *HW_LOCKER_UID = (void *)0xdeadbeef;
 
+/* How long the core is reserved for a port that was kept waiting */
+#define CORE_HANDOFF_JIFFIES msecs_to_jiffies(20)
+
 /***************************************************************************
 * ASIC access
 ***************************************************************************/
@@ -712,8 +726,20 @@ static int __acquire_sata_core(
 			 * same port for which the lock is current held
 			 */
 			if (hw_access && (port_no == hd->reentrant_port_no)) {
+				/* Stop extending the hold once the other port
+				 * has been kept waiting for a full batch
+				 */
+				if (!may_sleep &&
+				    (hd->port_waiting & ~BIT(port_no)) &&
+				    hd->core_batch >= SATA_OXNAS_CORE_BATCH) {
+					DPRINTK("Batch done on port %d\n",
+						port_no);
+					goto wait_for_lock;
+				}
+
 				BUG_ON(!hd->hw_lock_count);
 				++(hd->hw_lock_count);
+				++(hd->core_batch);
 
 				DPRINTK("Allow SCSI/SATA re-entrant access to "
 					"uid %p port %d\n", uid, port_no);
@@ -752,6 +778,20 @@ check_uid:
 					hd->direct_lock_count, hw_access);
 			}
 		} else {
+			/* The core has been handed to the port that was
+			 * kept waiting, give it a chance to claim it
+			 */
+			if (hd->handoff_port_no != -1 &&
+			    time_after_eq(jiffies, hd->handoff_expires)) {
+				/* It did not, stop treating it as waiting */
+				hd->port_waiting &= ~BIT(hd->handoff_port_no);
+				hd->handoff_port_no = -1;
+			}
+			if (hw_access && !may_sleep &&
+			    hd->handoff_port_no != -1 &&
+			    hd->handoff_port_no != port_no)
+				goto wait_for_lock;
+
 			WARN(hd->hw_lock_count || hd->direct_lock_count,
 				"Core unlocked but counts non-zero: uid %p, "
 				"locker_uid %p, port %d, h/w count %d, "
@@ -796,6 +836,8 @@ check_uid:
 
 				++(hd->hw_lock_count);
 				hd->reentrant_port_no = port_no;
+				hd->core_batch = 1;
+				hd->handoff_port_no = -1;
 
 				hd->current_locker_type = SATA_SCSI_STACK;
 			}
@@ -813,8 +855,10 @@ wait_for_lock:
 			"cannot sleep\n", uid, locker_type, hw_access, port_no,
 			hd->current_locker_type);
 
-			if (hw_access)
+			if (hw_access) {
 				++(hd->scsi_nonblocking_attempts);
+				hd->port_waiting |= BIT(port_no);
+			}
 
 			break;
 		}
@@ -868,6 +912,7 @@ wait_for_lock:
 	if (hw_access && acquired) {
 		if (hd->scsi_nonblocking_attempts)
 			hd->scsi_nonblocking_attempts = 0;
+		hd->port_waiting &= ~BIT(port_no);
 
 		/* Wake any other SCSI/SATA waiters so they can get reentrant
 		 * access to the same port if appropriate. This is because if
@@ -976,6 +1021,13 @@ static void sata_oxnas_release_hw(struct ata_port *ap)
 			DPRINTK("Still nested port_no %d\n", ap->port_no);
 		} else {
 			DPRINTK("Release port_no %d\n", ap->port_no);
+			if (hd->port_waiting & ~BIT(ap->port_no)) {
+				hd->handoff_port_no = __ffs(hd->port_waiting &
+							~BIT(ap->port_no));
+				hd->handoff_expires = jiffies +
+						      CORE_HANDOFF_JIFFIES;
+			}
+			hd->core_batch = 0;
 			hd->reentrant_port_no = -1;
 			hd->isr_callback = NULL;
 			hd->current_locker_type = SATA_UNLOCKED;
@@ -2386,6 +2438,7 @@ static int sata_oxnas_probe(struct platform_device *ofdev)
 	spin_lock_init(&host_priv->core_lock);
 	host_priv->core_locked = 0;
 	host_priv->reentrant_port_no = -1;
+	host_priv->handoff_port_no = -1;
 	host_priv->hw_lock_count = 0;
 	host_priv->direct_lock_count = 0;
 	host_priv->locker_uid = 0;
@@ -900,6 +900,8 @@ struct msdc_dma {
 	dma_addr_t bd_addr;          /* the physical address of bd array */
 };
 
+#define MSDC_LAT_BUCKETS    (20)      /* power of two usecs, up to ~0.5s */
+
 struct msdc_host {
 	struct msdc_hw              *hw;
 
@@ -945,6 +947,8 @@ struct msdc_host {
 	u8                          suspend;        /* host suspended ? */
 	u8                          app_cmd;        /* for app command */
 	u32                         app_cmd_arg;
+
+	u32                         lat_hist[2][MSDC_LAT_BUCKETS]; /* read, write */
 };
 
 #define sdr_read8(reg)            readb(reg)
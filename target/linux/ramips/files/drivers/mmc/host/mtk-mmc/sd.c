@@ -34,10 +34,12 @@
  */
 
 #include <linux/module.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/dma-mapping.h>
 #include <linux/spinlock.h>
 #include <linux/platform_device.h>
+#include <linux/seq_file.h>
 #include <linux/interrupt.h>
 
 #include <linux/mmc/host.h>
@@ -99,6 +101,8 @@
 #define MAX_SGMT_SZ         (MAX_DMA_CNT)
 #define MAX_REQ_SZ          (MAX_SGMT_SZ * 8)
 
+#define MSDC_PREPARE_FLAG   BIT(0)    /* data->sg mapped in pre_req */
+
 static int cd_active_low = 1;
 
 //=================================
@@ -1145,6 +1149,7 @@ static int msdc_do_request(struct mmc_host *mmc, struct mmc_request *mrq)
 	void __iomem *base = host->base;
 	//u32 intsts = 0;
 	int read = 1, send_type = 0;
+	bool mapped = false;
 
 #define SND_DAT 0
 #define SND_CMD 1
@@ -1195,9 +1200,13 @@ static int msdc_do_request(struct mmc_host *mmc, struct mmc_request *mrq)
 		if (msdc_command_start(host, cmd, 1, CMD_TIMEOUT) != 0)
 			goto done;
 
-		data->sg_count = dma_map_sg(mmc_dev(mmc), data->sg,
-					    data->sg_len,
-					    mmc_get_dma_dir(data));
+		/* Requests prepared by pre_req are already mapped */
+		if (!(data->host_cookie & MSDC_PREPARE_FLAG)) {
+			data->sg_count = dma_map_sg(mmc_dev(mmc), data->sg,
+						    data->sg_len,
+						    mmc_get_dma_dir(data));
+			mapped = true;
+		}
 		msdc_dma_setup(host, &host->dma, data->sg,
 			       data->sg_count);
 
@@ -1236,8 +1245,9 @@ static int msdc_do_request(struct mmc_host *mmc, struct mmc_request *mrq)
 done:
 	if (data != NULL) {
 		host->data = NULL;
-		dma_unmap_sg(mmc_dev(mmc), data->sg, data->sg_len,
-			     mmc_get_dma_dir(data));
+		if (mapped)
+			dma_unmap_sg(mmc_dev(mmc), data->sg, data->sg_len,
+				     mmc_get_dma_dir(data));
 		host->blksz = 0;
 
 #if 0 // don't stop twice!
@@ -1650,10 +1660,51 @@ static int msdc_tune_request(struct mmc_host *mmc, struct mmc_request *mrq)
 	return ret;
 }
 
+static void msdc_lat_account(struct msdc_host *host, struct mmc_data *data,
+			     ktime_t delta)
+	__must_hold(&host->lock)
+{
+	int dir = data->flags & MMC_DATA_READ ? 0 : 1;
+	u64 us = ktime_to_us(delta);
+	int bucket = us ? min_t(int, ilog2(us), MSDC_LAT_BUCKETS - 1) : 0;
+
+	host->lat_hist[dir][bucket]++;
+}
+
+/* ops.pre_req: map the next request while the current one is running */
+static void msdc_ops_pre_req(struct mmc_host *mmc, struct mmc_request *mrq)
+{
+	struct mmc_data *data = mrq->data;
+
+	if (!data)
+		return;
+
+	data->host_cookie &= ~MSDC_PREPARE_FLAG;
+	data->sg_count = dma_map_sg(mmc_dev(mmc), data->sg, data->sg_len,
+				    mmc_get_dma_dir(data));
+	if (data->sg_count)
+		data->host_cookie |= MSDC_PREPARE_FLAG;
+}
+
+/* ops.post_req */
+static void msdc_ops_post_req(struct mmc_host *mmc, struct mmc_request *mrq,
+			      int err)
+{
+	struct mmc_data *data = mrq->data;
+
+	if (!data || !(data->host_cookie & MSDC_PREPARE_FLAG))
+		return;
+
+	dma_unmap_sg(mmc_dev(mmc), data->sg, data->sg_len,
+		     mmc_get_dma_dir(data));
+	data->host_cookie &= ~MSDC_PREPARE_FLAG;
+}
+
 /* ops.request */
 static void msdc_ops_request(struct mmc_host *mmc, struct mmc_request *mrq)
 {
 	struct msdc_host *host = mmc_priv(mmc);
+	ktime_t start = ktime_get();
 
 	//=== for sdio profile ===
 #if 0 /* --- by chhung */
@@ -1710,6 +1761,8 @@ static void msdc_ops_request(struct mmc_host *mmc, struct mmc_request *mrq)
 		}
 	}
 #endif /* end of --- */
+	if (mrq->data)
+		msdc_lat_account(host, mrq->data, ktime_sub(ktime_get(), start));
 	spin_unlock(&host->lock);
 
 	mmc_request_done(mmc, mrq);
@@ -1873,6 +1926,8 @@ static int msdc_ops_get_cd(struct mmc_host *mmc)
 }
 
 static struct mmc_host_ops mt_msdc_ops = {
+	.pre_req         = msdc_ops_pre_req,
+	.post_req        = msdc_ops_post_req,
 	.request         = msdc_ops_request,
 	.set_ios         = msdc_ops_set_ios,
 	.get_ro          = msdc_ops_get_ro,
@@ -2179,6 +2234,60 @@ static void msdc_deinit_hw(struct msdc_host *host)
 	// msdc_set_power_mode(host, MMC_POWER_OFF);   /* make sure power down */ /* --- by chhung */
 }
 
+/*--------------------------------------------------------------------------*/
+/* debugfs                                                                  */
+/*--------------------------------------------------------------------------*/
+#ifdef CONFIG_DEBUG_FS
+static int msdc_lat_show(struct seq_file *s, void *p)
+{
+	struct msdc_host *host = s->private;
+	u32 hist[2][MSDC_LAT_BUCKETS];
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&host->lock, flags);
+	memcpy(hist, host->lat_hist, sizeof(hist));
+	spin_unlock_irqrestore(&host->lock, flags);
+
+	seq_puts(s, "usecs              read      write\n");
+	for (i = 0; i < MSDC_LAT_BUCKETS; i++)
+		seq_printf(s, "%s%-10lu %10u %10u\n",
+			   i == MSDC_LAT_BUCKETS - 1 ? ">=" : "< ",
+			   i == MSDC_LAT_BUCKETS - 1 ? 1UL << i : 2UL << i,
+			   hist[0][i], hist[1][i]);
+
+	return 0;
+}
+
+static int msdc_lat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, msdc_lat_show, inode->i_private);
+}
+
+static ssize_t msdc_lat_write(struct file *file, const char __user *buf,
+			      size_t count, loff_t *ppos)
+{
+	struct msdc_host *host = ((struct seq_file *)file->private_data)->private;
+	unsigned long flags;
+
+	/* Any write clears the histogram */
+	spin_lock_irqsave(&host->lock, flags);
+	memset(host->lat_hist, 0, sizeof(host->lat_hist));
+	spin_unlock_irqrestore(&host->lock, flags);
+
+	return count;
+}
+
+static const struct file_operations msdc_lat_fops = {
+	.owner		= THIS_MODULE,
+	.open		= msdc_lat_open,
+	.read		= seq_read,
+	.write		= msdc_lat_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+#endif
+
 /* init gpd and bd list in msdc_drv_probe */
 static void msdc_init_gpd_bd(struct msdc_host *host, struct msdc_dma *dma)
 {
@@ -2325,6 +2434,11 @@ static int msdc_drv_probe(struct platform_device *pdev)
 	if (ret)
 		goto release;
 
+#ifdef CONFIG_DEBUG_FS
+	debugfs_create_file("req_latency", 0600, mmc->debugfs_root, host,
+			    &msdc_lat_fops);
+#endif
+
 	/* Config card detection pin and enable interrupts */
 	if (hw->flags & MSDC_CD_PIN_EN) {  /* set for card */
 		msdc_enable_cd_irq(host, 1);
@@ -0,0 +1,258 @@
+/*   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; version 2 of the License
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/ktime.h>
+
+#include "mtk_eth_soc.h"
+
+static const char * const fe_stat_str[FE_STAT_COUNT] = {
+#define _FE(x)	[FE_STAT_##x] = # x,
+FE_STAT_REG_DECLARE
+#undef _FE
+};
+
+void fe_debugfs_update_napi_stats(struct fe_priv *priv, int rx, int tx)
+{
+	struct fe_napi_stats *stats = &priv->debug.napi_stats;
+
+	if (rx) {
+		stats->rx_count++;
+		stats->rx_packets += rx;
+		stats->rx[min(fls(rx), FE_NAPI_HIST_SIZE - 1)]++;
+		if (rx > stats->rx_packets_max)
+			stats->rx_packets_max = rx;
+	}
+
+	if (tx) {
+		stats->tx_count++;
+		stats->tx_packets += tx;
+		stats->tx[min(fls(tx), FE_NAPI_HIST_SIZE - 1)]++;
+		if (tx > stats->tx_packets_max)
+			stats->tx_packets_max = tx;
+	}
+}
+
+static int fe_napi_stats_show(struct seq_file *m, void *v)
+{
+	struct fe_priv *priv = m->private;
+	struct fe_napi_stats *stats = &priv->debug.napi_stats;
+	unsigned long rx_avg = 0;
+	unsigned long tx_avg = 0;
+	int i;
+
+	if (stats->rx_count)
+		rx_avg = stats->rx_packets / stats->rx_count;
+
+	if (stats->tx_count)
+		tx_avg = stats->tx_packets / stats->tx_count;
+
+	seq_printf(m, "ring size: rx %u, tx %u, napi weight %d\n\n",
+		   priv->rx_ring.rx_ring_size, priv->tx_ring.tx_ring_size,
+		   priv->rx_napi.weight);
+
+	seq_printf(m, "%9s  %10s %10s\n", "len", "rx", "tx");
+	for (i = 1; i < FE_NAPI_HIST_SIZE; i++)
+		seq_printf(m, "%4d-%-4d: %10lu %10lu\n",
+			   1 << (i - 1), (1 << i) - 1,
+			   stats->rx[i], stats->tx[i]);
+
+	seq_puts(m, "\n");
+	seq_printf(m, "%9s: %10lu %10lu\n", "sum",
+		   stats->rx_count, stats->tx_count);
+	seq_printf(m, "%9s: %10lu %10lu\n", "avg", rx_avg, tx_avg);
+	seq_printf(m, "%9s: %10lu %10lu\n", "max",
+		   stats->rx_packets_max, stats->tx_packets_max);
+	seq_printf(m, "%9s: %10lu %10lu\n", "pkt",
+		   stats->rx_packets, stats->tx_packets);
+
+	return 0;
+}
+
+static ssize_t fe_napi_stats_write(struct file *file, const char __user *buf,
+				   size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+	struct fe_priv *priv = m->private;
+
+	/* any write clears the histograms */
+	memset(&priv->debug.napi_stats, 0, sizeof(priv->debug.napi_stats));
+
+	return count;
+}
+
+static int fe_napi_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, fe_napi_stats_show, inode->i_private);
+}
+
+static const struct file_operations fe_fops_napi_stats = {
+	.open		= fe_napi_stats_open,
+	.read		= seq_read,
+	.write		= fe_napi_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+	.owner		= THIS_MODULE
+};
+
+static void fe_debugfs_show_interval(struct seq_file *m, ktime_t *stamp)
+{
+	ktime_t now = ktime_get();
+
+	seq_printf(m, "time: %lld ms, interval: %lld ms\n\n",
+		   ktime_to_ms(now), ktime_ms_delta(now, *stamp));
+	*stamp = now;
+}
+
+/* frame engine counters, and their change since the previous read */
+static int fe_stats_show(struct seq_file *m, void *v)
+{
+	struct fe_priv *priv = m->private;
+	struct fe_hw_stats *hwstats = priv->hw_stats;
+	u64 *last = priv->debug.stats_last;
+	u64 stats[FE_STAT_COUNT];
+	u64 *data_src;
+	unsigned int start;
+	int i;
+
+	spin_lock_bh(&hwstats->stats_lock);
+	fe_stats_update(priv);
+	spin_unlock_bh(&hwstats->stats_lock);
+
+	do {
+		data_src = &hwstats->tx_bytes;
+		start = u64_stats_fetch_begin_irq(&hwstats->syncp);
+
+		for (i = 0; i < FE_STAT_COUNT; i++)
+			stats[i] = data_src[i];
+
+	} while (u64_stats_fetch_retry_irq(&hwstats->syncp, start));
+
+	mutex_lock(&priv->debug.lock);
+
+	fe_debugfs_show_interval(m, &priv->debug.stats_stamp);
+
+	seq_printf(m, "%-24s %20s %20s\n", "counter", "total", "delta");
+	for (i = 0; i < FE_STAT_COUNT; i++) {
+		seq_printf(m, "%-24s %20llu %20llu\n", fe_stat_str[i],
+			   stats[i], stats[i] - last[i]);
+		last[i] = stats[i];
+	}
+
+	mutex_unlock(&priv->debug.lock);
+
+	return 0;
+}
+
+static int fe_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, fe_stats_show, inode->i_private);
+}
+
+static const struct file_operations fe_fops_stats = {
+	.open		= fe_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+	.owner		= THIS_MODULE
+};
+
+/*
+ * PPE accounting groups, the hardware counters that offloaded flows are
+ * attributed to. Like the GDMA counters they are cleared on read, so
+ * every pass folds all groups into the 64 bit totals at once.
+ */
+static int fe_ppe_acct_show(struct seq_file *m, void *v)
+{
+	struct fe_priv *priv = m->private;
+	struct fe_debug *debug = &priv->debug;
+	unsigned int base = priv->soc->reg_table[FE_REG_FE_COUNTER_BASE];
+	u64 bytes, packets;
+	int i;
+
+	mutex_lock(&debug->lock);
+
+	for (i = 0; i < FE_PPE_AC_GROUPS; i++) {
+		debug->ppe_bytes[i] += fe_r32(base + FE_PPE_AC_BCNT(i));
+		debug->ppe_packets[i] += fe_r32(base + FE_PPE_AC_PCNT(i));
+	}
+
+	fe_debugfs_show_interval(m, &debug->ppe_stamp);
+
+	seq_printf(m, "%5s %20s %20s %16s %16s\n", "group",
+		   "bytes", "packets", "delta bytes", "delta packets");
+	for (i = 0; i < FE_PPE_AC_GROUPS; i++) {
+		bytes = debug->ppe_bytes[i];
+		packets = debug->ppe_packets[i];
+		if (!packets)
+			continue;
+
+		seq_printf(m, "%5d %20llu %20llu %16llu %16llu\n", i,
+			   bytes, packets,
+			   bytes - debug->ppe_bytes_last[i],
+			   packets - debug->ppe_packets_last[i]);
+		debug->ppe_bytes_last[i] = bytes;
+		debug->ppe_packets_last[i] = packets;
+	}
+
+	mutex_unlock(&debug->lock);
+
+	return 0;
+}
+
+static int fe_ppe_acct_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, fe_ppe_acct_show, inode->i_private);
+}
+
+static const struct file_operations fe_fops_ppe_acct = {
+	.open		= fe_ppe_acct_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+	.owner		= THIS_MODULE
+};
+
+void fe_debugfs_exit(struct fe_priv *priv)
+{
+	debugfs_remove_recursive(priv->debug.debugfs_dir);
+	priv->debug.debugfs_dir = NULL;
+}
+
+void fe_debugfs_init(struct fe_priv *priv)
+{
+	struct fe_debug *debug = &priv->debug;
+
+	mutex_init(&debug->lock);
+	debug->stats_stamp = ktime_get();
+	debug->ppe_stamp = debug->stats_stamp;
+
+	debug->debugfs_dir = debugfs_create_dir(dev_name(priv->dev), NULL);
+	if (IS_ERR_OR_NULL(debug->debugfs_dir)) {
+		dev_err(priv->dev, "unable to create debugfs directory\n");
+		debug->debugfs_dir = NULL;
+		return;
+	}
+
+	debugfs_create_file("napi_stats", 0600, debug->debugfs_dir,
+			    priv, &fe_fops_napi_stats);
+
+	if (!priv->hw_stats)
+		return;
+
+	debugfs_create_file("stats", 0400, debug->debugfs_dir,
+			    priv, &fe_fops_stats);
+
+	/* the MT7621 counter block is laid out differently */
+	if (!IS_ENABLED(CONFIG_SOC_MT7621))
+		debugfs_create_file("ppe_acct", 0400, debug->debugfs_dir,
+				    priv, &fe_fops_ppe_acct);
+}
@@ -230,6 +230,7 @@ struct rt305x_esw {
 	bool			alt_vlan_disable;
 	int			bc_storm_protect;
 	int			led_frequency;
+	u32			port_link;
 	struct esw_vlan vlans[RT305X_ESW_NUM_VLANS];
 	struct esw_port ports[RT305X_ESW_NUM_PORTS];
 
@@ -719,10 +720,17 @@ static irqreturn_t esw_interrupt(int irq, void *_esw)
 	status = esw_r32(esw, RT305X_ESW_REG_ISR);
 	if (status & RT305X_ESW_PORT_ST_CHG) {
 		u32 link = esw_r32(esw, RT305X_ESW_REG_POA);
+		unsigned long changed;
+		int port;
 
 		link >>= RT305X_ESW_POA_LINK_SHIFT;
 		link &= RT305X_ESW_POA_LINK_MASK;
 		dev_info(esw->dev, "link changed 0x%02X\n", link);
+
+		changed = link ^ esw->port_link;
+		esw->port_link = link;
+		for_each_set_bit(port, &changed, RT305X_ESW_NUM_PORTS)
+			switch_port_link_changed(&esw->swdev, port);
 	}
 	esw_w32(esw, status, RT305X_ESW_REG_ISR);
 
@@ -1422,6 +1430,10 @@ static int esw_probe(struct platform_device *pdev)
 			       esw);
 
 	if (!ret) {
+		esw->port_link = esw_r32(esw, RT305X_ESW_REG_POA);
+		esw->port_link >>= RT305X_ESW_POA_LINK_SHIFT;
+		esw->port_link &= RT305X_ESW_POA_LINK_MASK;
+		esw->swdev.link_notify = true;
 		esw_w32(esw, RT305X_ESW_PORT_ST_CHG, RT305X_ESW_REG_ISR);
 		esw_w32(esw, ~RT305X_ESW_PORT_ST_CHG, RT305X_ESW_REG_IMR);
 	}
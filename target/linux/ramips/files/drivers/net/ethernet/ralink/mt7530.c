@@ -29,6 +29,7 @@
 #include <linux/netdevice.h>
 #include <linux/etherdevice.h>
 #include <linux/lockdep.h>
+#include <linux/sched.h>
 #include <linux/workqueue.h>
 #include <linux/of_device.h>
 #include <asm/byteorder.h>
@@ -174,6 +175,9 @@ struct mt7530_priv {
 	struct mii_bus		*bus;
 	struct switch_dev	swdev;
 
+	struct task_struct	*mdio_owner;
+	int			mdio_page;
+
 	u8			mirror_dest_port;
 	bool			global_vlan_enable;
 	struct mt7530_vlan_entry	vlan_entries[MT7530_NUM_VLANS];
@@ -283,16 +287,64 @@ mt7530_set_vlan_enable(struct switch_dev *dev,
 	return 0;
 }
 
+/*
+ * Hold the MDIO bus lock across a sequence of register accesses. The page
+ * register is only cached while the lock is held, as other users of the
+ * bus may change it in between. The owning task is recorded so that the
+ * register accessors only skip locking for the task that holds the bus.
+ */
+static void
+mt7530_mdio_lock(struct mt7530_priv *priv)
+{
+	if (!priv->bus)
+		return;
+
+	mutex_lock(&priv->bus->mdio_lock);
+	WRITE_ONCE(priv->mdio_owner, current);
+	priv->mdio_page = -1;
+}
+
+static void
+mt7530_mdio_unlock(struct mt7530_priv *priv)
+{
+	if (!priv->bus)
+		return;
+
+	WRITE_ONCE(priv->mdio_owner, NULL);
+	mutex_unlock(&priv->bus->mdio_lock);
+}
+
+static void
+mt7530_mdio_page(struct mt7530_priv *priv, u32 reg)
+{
+	struct mii_bus *bus = priv->bus;
+	int page = (reg >> 6) & 0x3ff;
+
+	if (priv->mdio_page == page)
+		return;
+
+	__mdiobus_write(bus, 0x1f, 0x1f, page);
+	priv->mdio_page = page;
+}
+
 static u32
 mt7530_r32(struct mt7530_priv *priv, u32 reg)
 {
 	u32 val;
 	if (priv->bus) {
+		struct mii_bus *bus = priv->bus;
+		bool locked = READ_ONCE(priv->mdio_owner) == current;
 		u16 high, low;
 
-		mdiobus_write(priv->bus, 0x1f, 0x1f, (reg >> 6) & 0x3ff);
-		low = mdiobus_read(priv->bus, 0x1f, (reg >> 2) & 0xf);
-		high = mdiobus_read(priv->bus, 0x1f, 0x10);
+		if (!locked)
+			mt7530_mdio_lock(priv);
+
+		mt7530_mdio_page(priv, reg);
+		low = __mdiobus_read(bus, 0x1f, (reg >> 2) & 0xf);
+		high = __mdiobus_read(bus, 0x1f, 0x10);
+
+		if (!locked)
+			mt7530_mdio_unlock(priv);
 
 		return (high << 16) | (low & 0xffff);
 	}
@@ -307,9 +359,18 @@ static void
 mt7530_w32(struct mt7530_priv *priv, u32 reg, u32 val)
 {
 	if (priv->bus) {
-		mdiobus_write(priv->bus, 0x1f, 0x1f, (reg >> 6) & 0x3ff);
-		mdiobus_write(priv->bus, 0x1f, (reg >> 2) & 0xf,  val & 0xffff);
-		mdiobus_write(priv->bus, 0x1f, 0x10, val >> 16);
+		struct mii_bus *bus = priv->bus;
+		bool locked = READ_ONCE(priv->mdio_owner) == current;
+
+		if (!locked)
+			mt7530_mdio_lock(priv);
+
+		mt7530_mdio_page(priv, reg);
+		__mdiobus_write(bus, 0x1f, (reg >> 2) & 0xf, val & 0xffff);
+		__mdiobus_write(bus, 0x1f, 0x10, val >> 16);
+
+		if (!locked)
+			mt7530_mdio_unlock(priv);
 		return;
 	}
 
@@ -379,6 +440,8 @@ mt7530_get_vlan_ports(struct switch_dev *dev, struct switch_val *val)
 	if (val->port_vlan < 0 || val->port_vlan >= MT7530_NUM_VLANS)
 		return -EINVAL;
 
+	mt7530_mdio_lock(priv);
+
 	mt7530_vtcr(priv, 0, val->port_vlan);
 
 	member = mt7530_r32(priv, REG_ESW_VLAN_VAWD1);
@@ -387,6 +450,8 @@ mt7530_get_vlan_ports(struct switch_dev *dev, struct switch_val *val)
 
 	etags = mt7530_r32(priv, REG_ESW_VLAN_VAWD2);
 
+	mt7530_mdio_unlock(priv);
+
 	for (i = 0; i < MT7530_NUM_PORTS; i++) {
 		struct switch_port *p;
 		int etag;
@@ -593,6 +658,8 @@ mt7530_apply_config(struct switch_dev *dev)
 	u8 untag_ports;
 	bool is_mirror = false;
 
+	mt7530_mdio_lock(priv);
+
 	if (!priv->global_vlan_enable) {
 		for (i = 0; i < MT7530_NUM_PORTS; i++)
 			mt7530_w32(priv, REG_ESW_PORT_PCR(i), 0x00400000);
@@ -602,7 +669,7 @@ mt7530_apply_config(struct switch_dev *dev)
 		for (i = 0; i < MT7530_NUM_PORTS; i++)
 			mt7530_w32(priv, REG_ESW_PORT_PVC(i), 0x810000c0);
 
-		return 0;
+		goto out;
 	}
 
 	/* set all ports as security mode */
@@ -696,6 +763,9 @@ mt7530_apply_config(struct switch_dev *dev)
 		mt7530_w32(priv, REG_ESW_WT_MAC_MFC, val);
 	}
 
+out:
+	mt7530_mdio_unlock(priv);
+
 	return 0;
 }
 
@@ -757,6 +827,7 @@ static int mt7530_sw_get_mib(struct switch_dev *dev,
 
 	len += snprintf(buf + len, sizeof(buf) - len, "Switch MIB counters\n");
 
+	mt7530_mdio_lock(priv);
 	for (i = 0; i < ARRAY_SIZE(mt7620_mibs); ++i) {
 		u64 counter;
 		len += snprintf(buf + len, sizeof(buf) - len,
@@ -765,6 +836,7 @@ static int mt7530_sw_get_mib(struct switch_dev *dev,
 		len += snprintf(buf + len, sizeof(buf) - len, "%llu\n",
 				counter);
 	}
+	mt7530_mdio_unlock(priv);
 
 	val->value.s = buf;
 	val->len = len;
@@ -824,6 +896,8 @@ static int mt7530_get_arl_table(struct switch_dev *dev,
 	buf += ret;
 	size = size - ret;
 
+	mt7530_mdio_lock(priv);
+
 	mt7530_w32(priv, REG_ESW_WT_MAC_ATC, REG_MAC_ATC_START);
 
 	do {
@@ -846,18 +920,23 @@ static int mt7530_get_arl_table(struct switch_dev *dev,
 				buf = mt7530_print_arl_table_row(atrd, mac1, mac2, buf, &size);
 				if (!buf) {
 					pr_warn("%s: too many addresses\n", __func__);
-					goto out;
+					goto unlock;
 				}
 			} else if (!(atc & REG_MAC_ATC_SRCH_END)) {
 				mt7530_w32(priv, REG_ESW_WT_MAC_ATC, REG_MAC_ATC_NEXT);
 			}
 		} else {
+			/* don't hold off other bus users while waiting */
+			mt7530_mdio_unlock(priv);
 			--retry_times;
 			usleep_range(1000, 5000);
+			mt7530_mdio_lock(priv);
 		}
 	} while (!(atc & REG_MAC_ATC_SRCH_END) &&
 		 count < MT7530_NUM_ARL_RECORDS &&
 		 retry_times > 0);
+unlock:
+	mt7530_mdio_unlock(priv);
 out:
 	val->value.s = priv->arl_buf;
 	val->len = strlen(priv->arl_buf);
@@ -879,6 +958,7 @@ static int mt7530_sw_get_port_mib(struct switch_dev *dev,
 	len += snprintf(buf + len, sizeof(buf) - len,
 			"Port %d MIB counters\n", val->port_vlan);
 
+	mt7530_mdio_lock(priv);
 	for (i = 0; i < ARRAY_SIZE(mt7620_port_mibs); ++i) {
 		u64 counter;
 		len += snprintf(buf + len, sizeof(buf) - len,
@@ -887,6 +967,7 @@ static int mt7530_sw_get_port_mib(struct switch_dev *dev,
 		len += snprintf(buf + len, sizeof(buf) - len, "%llu\n",
 				counter);
 	}
+	mt7530_mdio_unlock(priv);
 
 	val->value.s = buf;
 	val->len = len;
@@ -901,8 +982,10 @@ static int mt7530_get_port_stats(struct switch_dev *dev, int port,
 	if (port < 0 || port >= MT7530_NUM_PORTS)
 		return -EINVAL;
 
+	mt7530_mdio_lock(priv);
 	stats->tx_bytes = get_mib_counter_port_7620(priv, MT7530_PORT_MIB_TXB_ID, port);
 	stats->rx_bytes = get_mib_counter_port_7620(priv, MT7530_PORT_MIB_RXB_ID, port);
+	mt7530_mdio_unlock(priv);
 
 	return 0;
 }
@@ -1052,6 +1052,8 @@ static int fe_poll(struct napi_struct *napi, int budget)
 	if (status & rx_intr)
 		rx_done = fe_poll_rx(napi, budget, priv, rx_intr);
 
+	fe_debugfs_update_napi_stats(priv, rx_done, tx_done);
+
 	if (unlikely(fe_status & status_intr)) {
 		if (hwstat && spin_trylock(&hwstat->stats_lock)) {
 			fe_stats_update(priv);
@@ -1647,6 +1649,7 @@ static int fe_probe(struct platform_device *pdev)
 	}
 
 	platform_set_drvdata(pdev, netdev);
+	fe_debugfs_init(priv);
 
 	netif_info(priv, probe, netdev, "mediatek frame engine at 0x%08lx, irq %d\n",
 		   netdev->base_addr, netdev->irq);
@@ -1666,6 +1669,7 @@ static int fe_remove(struct platform_device *pdev)
 	struct net_device *dev = platform_get_drvdata(pdev);
 	struct fe_priv *priv = netdev_priv(dev);
 
+	fe_debugfs_exit(priv);
 	netif_napi_del(&priv->rx_napi);
 	kfree(priv->hw_stats);
 
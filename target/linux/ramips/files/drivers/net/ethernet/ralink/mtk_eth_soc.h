@@ -344,6 +344,11 @@ struct fe_rx_dma {
 #define FE_GDMA1_TX_GBCNT	(FE_CMTABLE_OFFSET + 0x300)
 #define FE_GDMA2_TX_GBCNT	(FE_GDMA1_TX_GBCNT + 0x40)
 
+/* PPE accounting groups, relative to the GDMA1 counters */
+#define FE_PPE_AC_GROUPS	64
+#define FE_PPE_AC_BCNT(_x)	(FE_PPE_AC_BCNT0 - FE_GDMA1_TX_GBCNT + (_x) * 8)
+#define FE_PPE_AC_PCNT(_x)	(FE_PPE_AC_BCNT(_x) + 4)
+
 /* phy device flags */
 #define FE_PHY_FLAG_PORT	BIT(0)
 #define FE_PHY_FLAG_ATTACH	BIT(1)
@@ -424,6 +429,13 @@ struct fe_soc_data {
 	_FE(rx_checksum_errors)		\
 	_FE(rx_flow_control_packets)
 
+enum fe_stat_reg {
+#define _FE(x) FE_STAT_##x,
+	FE_STAT_REG_DECLARE
+#undef _FE
+	FE_STAT_COUNT
+};
+
 struct fe_hw_stats {
 	/* make sure that stats operations are atomic */
 	spinlock_t stats_lock;
@@ -434,6 +446,40 @@ struct fe_hw_stats {
 #undef _FE
 };
 
+/* packets per napi poll, in power of two buckets */
+#define FE_NAPI_HIST_SIZE	8
+
+struct fe_napi_stats {
+	unsigned long		rx_count;
+	unsigned long		rx_packets;
+	unsigned long		rx_packets_max;
+
+	unsigned long		tx_count;
+	unsigned long		tx_packets;
+	unsigned long		tx_packets_max;
+
+	unsigned long		rx[FE_NAPI_HIST_SIZE];
+	unsigned long		tx[FE_NAPI_HIST_SIZE];
+};
+
+struct fe_debug {
+	struct dentry		*debugfs_dir;
+
+	/* serializes the delta snapshots of the files below */
+	struct mutex		lock;
+
+	struct fe_napi_stats	napi_stats;
+
+	u64			stats_last[FE_STAT_COUNT];
+	ktime_t			stats_stamp;
+
+	u64			ppe_bytes[FE_PPE_AC_GROUPS];
+	u64			ppe_packets[FE_PPE_AC_GROUPS];
+	u64			ppe_bytes_last[FE_PPE_AC_GROUPS];
+	u64			ppe_packets_last[FE_PPE_AC_GROUPS];
+	ktime_t			ppe_stamp;
+};
+
 struct fe_tx_buf {
 	struct sk_buff *skb;
 	DEFINE_DMA_UNMAP_ADDR(dma_addr0);
@@ -497,6 +543,10 @@ struct fe_priv {
 	struct mtk_foe_entry		*foe_table;
 	dma_addr_t			foe_table_phys;
 	struct flow_offload __rcu	**foe_flow_table;
+
+#ifdef CONFIG_NET_RALINK_DEBUG_FS
+	struct fe_debug			debug;
+#endif
 };
 
 extern const struct of_device_id of_fe_match[];
@@ -514,6 +564,17 @@ u32 fe_reg_r32(enum fe_reg reg);
 
 void fe_reset(u32 reset_bits);
 
+#ifdef CONFIG_NET_RALINK_DEBUG_FS
+void fe_debugfs_init(struct fe_priv *priv);
+void fe_debugfs_exit(struct fe_priv *priv);
+void fe_debugfs_update_napi_stats(struct fe_priv *priv, int rx, int tx);
+#else
+static inline void fe_debugfs_init(struct fe_priv *priv) {}
+static inline void fe_debugfs_exit(struct fe_priv *priv) {}
+static inline void fe_debugfs_update_napi_stats(struct fe_priv *priv,
+						int rx, int tx) {}
+#endif
+
 static inline void *priv_netdev(struct fe_priv *priv)
 {
 	return (char *)priv - ALIGN(sizeof(struct net_device), NETDEV_ALIGN);
@@ -13,6 +13,7 @@
 #include <linux/mtd/spi-nor.h>
 
 #include "rtl838x-spi.h"
+#include <asm/unaligned.h>
 #include <asm/mach-rtl838x/mach-rtl83xx.h>
 
 extern struct rtl83xx_soc_info soc_info;
@@ -21,12 +22,44 @@ struct rtl838x_nor {
 	struct spi_nor nor;
 	struct device *dev;
 	volatile void __iomem *base;
+	void __iomem *mmio;		/* memory mapped flash window, optional */
+	resource_size_t mmio_size;
 	bool fourByteMode;
 	u32 chipSize;
 	uint32_t flags;
 	uint32_t io_status;
+	uint8_t read_cmd;		/* 3-byte address read opcode */
+	uint8_t read_cmd_4b;		/* 4-byte address read opcode */
+	uint32_t data_io;		/* IO-width of the read data phase */
 };
 
+/*
+ * Translate the read protocol negotiated by spi_nor_scan() into the
+ * opcodes and the IO-width encoding (0: x1, 1: x2, 2: x4) used by both
+ * the SFCSR and the SFCR2 memory mapped read engine
+ */
+static void rtl838x_nor_set_read_proto(struct rtl838x_nor *rtl838x_nor)
+{
+	switch (spi_nor_get_protocol_data_nbits(rtl838x_nor->nor.read_proto)) {
+	case 4:
+		rtl838x_nor->read_cmd = SPINOR_OP_READ_1_1_4;
+		rtl838x_nor->read_cmd_4b = SPINOR_OP_READ_1_1_4_4B;
+		rtl838x_nor->data_io = 2;
+		break;
+	case 2:
+		rtl838x_nor->read_cmd = SPINOR_OP_READ_1_1_2;
+		rtl838x_nor->read_cmd_4b = SPINOR_OP_READ_1_1_2_4B;
+		rtl838x_nor->data_io = 1;
+		break;
+	default:
+		rtl838x_nor->read_cmd = SPINOR_OP_READ_FAST;
+		rtl838x_nor->read_cmd_4b = SPINOR_OP_READ_FAST_4B;
+		rtl838x_nor->data_io = 0;
+	}
+	pr_info("Using read opcode %02x, %d data lines\n", rtl838x_nor->read_cmd,
+		1 << rtl838x_nor->data_io);
+}
+
 static uint32_t spi_prep(struct rtl838x_nor *rtl838x_nor)
 {
 	/* Needed because of MMU constraints */
@@ -143,10 +176,10 @@ ssize_t rtl838x_do_read(struct rtl838x_nor *rtl838x_nor, loff_t from,
 	spi_w32w(sfcsr, SFCSR);
 	spi_w32w(sfdr, SFDR);
 
-	/* Read Data, 4 bytes at a time */
+	/* Read Data, 4 bytes at a time, the buffer may not be aligned */
 	while (length >= 4) {
 		SPI_WAIT_READY;
-		*((uint32_t *) buffer) = spi_r32(SFDR);
+		put_unaligned(spi_r32(SFDR), (uint32_t *) buffer);
 		buffer += 4;
 		length -= 4;
 	}
@@ -191,13 +224,13 @@ static ssize_t rtl838x_do_4bf_read(struct rtl838x_nor *rtl838x_nor, loff_t from,
 	spi_w32w(sfcsr | SPI_LEN1, SFCSR);
 	spi_w32w(0, SFDR);
 
-	/* Start reading */
-	spi_w32w(sfcsr | SPI_LEN4, SFCSR);
+	/* Start reading, dual/quad fast reads only widen the data phase */
+	spi_w32w(sfcsr | SPI_LEN4 | SFCSR_IO_WIDTH(rtl838x_nor->data_io), SFCSR);
 
-	/* Read Data, 4 bytes at a time */
+	/* Read Data, 4 bytes at a time, the buffer may not be aligned */
 	while (length >= 4) {
 		SPI_WAIT_READY;
-		*((uint32_t *) buffer) = spi_r32(SFDR);
+		put_unaligned(spi_r32(SFDR), (uint32_t *) buffer);
 		buffer += 4;
 		length -= 4;
 	}
@@ -205,7 +238,7 @@ static ssize_t rtl838x_do_4bf_read(struct rtl838x_nor *rtl838x_nor, loff_t from,
 	/* The rest needs to be read 1 byte a time */
 	sfcsr &= SPI_LEN_INIT|SPI_LEN1;
 	SPI_WAIT_READY;
-	spi_w32w(sfcsr, SFCSR);
+	spi_w32w(sfcsr | SFCSR_IO_WIDTH(rtl838x_nor->data_io), SFCSR);
 	while (length > 0) {
 		SPI_WAIT_READY;
 		*(buffer) = spi_r32(SFDR) >> 24;
@@ -216,6 +249,23 @@ static ssize_t rtl838x_do_4bf_read(struct rtl838x_nor *rtl838x_nor, loff_t from,
 
 }
 
+/*
+ * Read through the memory mapped flash window. The SFCR2 read engine was
+ * set up in spi_enter_sio() with the same opcode and IO-width as the
+ * register based path, so the CPU simply copies out of the window.
+ */
+static ssize_t rtl838x_do_mmio_read(struct rtl838x_nor *rtl838x_nor, loff_t from,
+				    size_t length, u_char *buffer)
+{
+	pr_debug("MMIO read from %llx, len %zx\n", from, length);
+
+	/* The window must not be accessed while a register transfer runs */
+	spi_prep(rtl838x_nor);
+	memcpy_fromio(buffer, rtl838x_nor->mmio + from, length);
+
+	return length;
+}
+
 /*
  * Do write (Page Programming) in 3 or 4 Byte addressing mode
  */
@@ -240,23 +290,15 @@ static ssize_t rtl838x_do_4b_write(struct rtl838x_nor *rtl838x_nor, loff_t to,
 	spi_w32w(sfcsr | (sfcsr_addr_len << 28) | (0 << 25), SFCSR);
 	spi_w32w(to << sfdr_addr_shift, SFDR);
 
-	/* Write Data, 1 byte at a time, if we are not 4-byte aligned */
-	if (((long)buffer) % 4) {
-		spi_w32w(sfcsr | SPI_LEN1, SFCSR);
-		while (length > 0 && (((long)buffer) % 4)) {
-			SPI_WAIT_READY;
-			spi_w32(*(buffer) << 24, SFDR);
-			buffer += 1;
-			length -= 1;
-		}
-	}
-
-	/* Now we can write 4 bytes at a time */
+	/*
+	 * Write the page 4 bytes at a time while CS stays asserted, the
+	 * buffer alignment does not matter for the data register
+	 */
 	SPI_WAIT_READY;
 	spi_w32w(sfcsr | SPI_LEN4, SFCSR);
 	while (length >= 4) {
 		SPI_WAIT_READY;
-		spi_w32(*((uint32_t *)buffer), SFDR);
+		spi_w32(get_unaligned((uint32_t *)buffer), SFDR);
 		buffer += 4;
 		length -= 4;
 	}
@@ -310,7 +352,7 @@ static ssize_t rtl838x_nor_write(struct spi_nor *nor, loff_t to, size_t len,
 			spi_write_enable(rtl838x_nor);
 		} while (!(rtl838x_nor_get_SR(rtl838x_nor) & SPI_WEL));
 		ret = rtl838x_do_4b_write(rtl838x_nor, to+offset,
-					  len, buffer+offset, cmd);
+					  l, buffer+offset, cmd);
 	}
 
 	return len;
@@ -320,23 +362,25 @@ static ssize_t rtl838x_nor_read(struct spi_nor *nor, loff_t from,
 				size_t length, u_char *buffer)
 {
 	uint32_t offset = 0;
-	uint8_t cmd = SPINOR_OP_READ_FAST;
-	size_t l = length;
 	struct rtl838x_nor *rtl838x_nor = nor->priv;
-
-	/* Do fast read in 3, or 4-byte mode on large Macronix chips */
-	if (rtl838x_nor->fourByteMode) {
-		cmd = SPINOR_OP_READ_FAST_4B;
-		spi_4b_set(rtl838x_nor, true);
-	}
+	uint8_t cmd = rtl838x_nor->read_cmd;
+	size_t l = length;
 
 	/* TODO: do timeout and return error */
 	pr_debug("Waiting for pending writes\n");
 	while
 		(rtl838x_nor_get_SR(rtl838x_nor) & SPI_WIP);
-	do {
-		spi_write_enable(rtl838x_nor);
-	} while (!(rtl838x_nor_get_SR(rtl838x_nor) & SPI_WEL));
+
+	/* The flash window only covers the 3-byte addressable area */
+	if (rtl838x_nor->mmio && !rtl838x_nor->fourByteMode
+	    && from + length <= rtl838x_nor->mmio_size)
+		return rtl838x_do_mmio_read(rtl838x_nor, from, length, buffer);
+
+	/* Do fast read in 3, or 4-byte mode on large Macronix chips */
+	if (rtl838x_nor->fourByteMode) {
+		cmd = rtl838x_nor->read_cmd_4b;
+		spi_4b_set(rtl838x_nor, true);
+	}
 
 	pr_debug("cmd is %d\n", cmd);
 	pr_debug("%s: addr %.8llx to addr %.8x, cmd %.8x, size %d\n", __func__,
@@ -451,10 +495,21 @@ static int spi_enter_sio(struct spi_nor *nor)
 						  (reg & SFCR2_RDOPT));
 	size_bits = rtl838x_nor->fourByteMode ? SFCR2_SIZE(0x6) : SFCR2_SIZE(0x7);
 
-	sfcr2 = SFCR2_HOLD_TILL_SFDR2 | size_bits
+	/*
+	 * The read engine counts dummy cycles in pairs. It is only switched to
+	 * dual/quad reads in 3-byte mode, where the window is used by the driver
+	 */
+	if (rtl838x_nor->fourByteMode)
+		sfcr2 = SFCR2_DUMMYCYCLE(4) | SFCR2_DATAIO(0)
+			| SFCR2_SFCMD(SPINOR_OP_READ_FAST);
+	else
+		sfcr2 = SFCR2_DUMMYCYCLE(nor->read_dummy / 2)
+			| SFCR2_DATAIO(rtl838x_nor->data_io)
+			| SFCR2_SFCMD(rtl838x_nor->read_cmd);
+
+	sfcr2 |= SFCR2_HOLD_TILL_SFDR2 | size_bits
 		| (reg & SFCR2_RDOPT) | SFCR2_CMDIO(0)
-		| SFCR2_ADDRIO(0) | SFCR2_DUMMYCYCLE(4)
-		| SFCR2_DATAIO(0) | SFCR2_SFCMD(SPINOR_OP_READ_FAST);
+		| SFCR2_ADDRIO(0);
 	pr_debug("SFCR2: %x, size %x\n", reg, SFCR2_GETSIZE(reg));
 
 	SPI_WAIT_READY;
@@ -473,12 +528,14 @@ static int spi_enter_sio(struct spi_nor *nor)
 
 int rtl838x_spi_nor_scan(struct spi_nor *nor, const char *name)
 {
-	static const struct spi_nor_hwcaps hwcaps = {
+	struct spi_nor_hwcaps hwcaps = {
 		.mask = SNOR_HWCAPS_READ | SNOR_HWCAPS_PP
 			| SNOR_HWCAPS_READ_FAST
 	};
-
+	struct device_node *np = spi_nor_get_flash_node(nor);
 	struct rtl838x_nor *rtl838x_nor = nor->priv;
+	u32 rx_width;
+	int ret;
 
 	pr_debug("In %s\n", __func__);
 
@@ -487,9 +544,21 @@ int rtl838x_spi_nor_scan(struct spi_nor *nor, const char *name)
 
 	rtl838x_nor->flags = CS0 | R_MODE;
 
-	spi_nor_scan(nor, NULL, &hwcaps);
+	/* Dual/quad data lines need to be wired up, so the DT has to say so */
+	if (!of_property_read_u32(np, "spi-rx-bus-width", &rx_width)) {
+		if (rx_width >= 2)
+			hwcaps.mask |= SNOR_HWCAPS_READ_1_1_2;
+		if (rx_width >= 4)
+			hwcaps.mask |= SNOR_HWCAPS_READ_1_1_4;
+	}
+
+	ret = spi_nor_scan(nor, NULL, &hwcaps);
+	if (ret)
+		return ret;
 	pr_debug("------------- Got size: %llx\n", nor->mtd.size);
 
+	rtl838x_nor_set_read_proto(rtl838x_nor);
+
 	return 0;
 }
 
@@ -552,6 +621,20 @@ static int rtl838x_nor_drv_probe(struct platform_device *pdev)
 	pr_info("SPI resource base is %08x\n", (u32)rtl838x_nor->base);
 	rtl838x_nor->dev = &pdev->dev;
 
+	/* The memory mapped flash window is optional, fall back to SFDR reads */
+	res = platform_get_resource(pdev, IORESOURCE_MEM, 1);
+	if (res) {
+		rtl838x_nor->mmio = devm_ioremap_resource(&pdev->dev, res);
+		if (IS_ERR(rtl838x_nor->mmio)) {
+			dev_warn(&pdev->dev, "cannot map flash window\n");
+			rtl838x_nor->mmio = NULL;
+		} else {
+			rtl838x_nor->mmio_size = resource_size(res);
+			pr_info("Flash window at %08x, size %x\n",
+				(u32)rtl838x_nor->mmio, (u32)rtl838x_nor->mmio_size);
+		}
+	}
+
 	/* only support one attached flash */
 	flash_np = of_get_next_available_child(pdev->dev.of_node, NULL);
 	if (!flash_np) {
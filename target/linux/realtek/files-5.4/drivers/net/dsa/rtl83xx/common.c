@@ -2,6 +2,7 @@
 
 #include <linux/of_mdio.h>
 #include <linux/of_platform.h>
+#include <net/switchdev.h>
 
 #include <asm/mach-rtl838x/mach-rtl83xx.h>
 #include "rtl83xx.h"
@@ -550,6 +551,52 @@ static int rtl83xx_netdevice_event(struct notifier_block *this,
 	return NOTIFY_DONE;
 }
 
+static void rtl83xx_fdb_event_work(struct work_struct *work)
+{
+	struct rtl83xx_fdb_event_work *w =
+		container_of(work, struct rtl83xx_fdb_event_work, work);
+
+	rtl83xx_fdb_shadow_event(w->priv, w->mac, w->vid, w->add);
+	kfree(w);
+}
+
+/* The ethernet driver forwards the switch's L2 notification ring as
+ * switchdev FDB events on the CPU port's master device. Use them to keep
+ * the FDB shadow current.
+ */
+static int rtl83xx_switchdev_event(struct notifier_block *this,
+				   unsigned long event, void *ptr)
+{
+	struct net_device *ndev = switchdev_notifier_info_to_dev(ptr);
+	struct switchdev_notifier_fdb_info *info = ptr;
+	struct rtl838x_switch_priv *priv;
+	struct rtl83xx_fdb_event_work *w;
+
+	if (event != SWITCHDEV_FDB_ADD_TO_BRIDGE && event != SWITCHDEV_FDB_DEL_TO_BRIDGE)
+		return NOTIFY_DONE;
+
+	priv = container_of(this, struct rtl838x_switch_priv, fdb_nb);
+	if (!netdev_uses_dsa(ndev) || ndev->dsa_ptr->ds != priv->ds)
+		return NOTIFY_DONE;
+
+	/* Called in atomic context, the table lookup needs reg_mutex */
+	w = kzalloc(sizeof(*w), GFP_ATOMIC);
+	if (!w) {
+		/* Event lost, have the next dump rebuild the shadow */
+		WRITE_ONCE(priv->fdb_stale, true);
+		return NOTIFY_DONE;
+	}
+
+	INIT_WORK(&w->work, rtl83xx_fdb_event_work);
+	w->priv = priv;
+	w->mac = ether_addr_to_u64(info->addr);
+	w->vid = info->vid;
+	w->add = event == SWITCHDEV_FDB_ADD_TO_BRIDGE;
+	schedule_work(&w->work);
+
+	return NOTIFY_DONE;
+}
+
 static int __init rtl83xx_sw_probe(struct platform_device *pdev)
 {
 	int err = 0, i;
@@ -578,6 +625,11 @@ static int __init rtl83xx_sw_probe(struct platform_device *pdev)
 	priv->ds->priv = priv;
 	priv->ds->ops = &rtl83xx_switch_ops;
 	priv->dev = dev;
+	mutex_init(&priv->reg_mutex);
+	hash_init(priv->fdb_shadow);
+	priv->fdb_cache = KMEM_CACHE(rtl83xx_fdb_entry, 0);
+	if (!priv->fdb_cache)
+		return -ENOMEM;
 
 	priv->family_id = soc_info.family;
 	priv->id = soc_info.id;
@@ -603,6 +655,7 @@ static int __init rtl83xx_sw_probe(struct platform_device *pdev)
 		priv->r = &rtl839x_reg;
 		priv->ds->num_ports = 53;
 		priv->fib_entries = 16384;
+		priv->fdb_notify = true;
 		rtl8390_get_version(priv);
 		priv->n_lags = 16;
 		break;
@@ -639,12 +692,12 @@ static int __init rtl83xx_sw_probe(struct platform_device *pdev)
 		/* Probing fails the 1st time because of missing ethernet driver
 		 * initialization. Use this to disable traffic in case the bootloader left if on
 		 */
-		return err;
+		goto err_free_cache;
 	}
 	err = dsa_register_switch(priv->ds);
 	if (err) {
 		dev_err(dev, "Error registering switch: %d\n", err);
-		return err;
+		goto err_free_cache;
 	}
 
 	/* Enable link and media change interrupts. Are the SERDES masks needed? */
@@ -675,7 +728,7 @@ static int __init rtl83xx_sw_probe(struct platform_device *pdev)
 	}
 	if (err) {
 		dev_err(dev, "Error setting up switch interrupt.\n");
-		/* Need to free allocated switch here */
+		goto err_unregister_switch;
 	}
 
 	/* Enable interrupts for switch, on RTL931x, the IRQ is always on globally */
@@ -696,6 +749,16 @@ static int __init rtl83xx_sw_probe(struct platform_device *pdev)
 			dev_err(dev, "Failed to register LAG netdev notifier\n");
 	}
 
+	if (priv->fdb_notify) {
+		priv->fdb_nb.notifier_call = rtl83xx_switchdev_event;
+		if (register_switchdev_notifier(&priv->fdb_nb)) {
+			priv->fdb_nb.notifier_call = NULL;
+			priv->fdb_notify = false;
+			dev_err(dev, "Failed to register FDB switchdev notifier\n");
+		}
+	}
+	rtl83xx_fdb_shadow_sync(priv);
+
 	// Flood BPDUs to all ports including cpu-port
 	if (soc_info.family != RTL9300_FAMILY_ID) { // TODO: Port this functionality
 		bpdu_mask = soc_info.family == RTL8380_FAMILY_ID ? 0x1FFFFFFF : 0x1FFFFFFFFFFFFF;
@@ -707,6 +770,12 @@ static int __init rtl83xx_sw_probe(struct platform_device *pdev)
 		rtl838x_dbgfs_init(priv);
 	}
 
+	return 0;
+
+err_unregister_switch:
+	dsa_unregister_switch(priv->ds);
+err_free_cache:
+	kmem_cache_destroy(priv->fdb_cache);
 	return err;
 }
 
@@ -214,6 +214,26 @@ static const struct file_operations port_egress_fops = {
 };
 
 
+static int mib_show(struct seq_file *m, void *v)
+{
+	struct rtl838x_port *p = m->private;
+
+	return rtl83xx_mib_show(m, p->dp->ds->priv, p->dp->index);
+}
+
+static int mib_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, mib_show, inode->i_private);
+}
+
+static const struct file_operations mib_fops = {
+	.owner = THIS_MODULE,
+	.open = mib_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static const struct debugfs_reg32 port_ctrl_regs[] = {
 	{ .name = "port_isolation", .offset = RTL838X_PORT_ISO_CTRL(0), },
 	{ .name = "mac_force_mode", .offset = RTL838X_MAC_FORCE_MODE_CTRL, },
@@ -263,6 +283,7 @@ static int rtl838x_dbgfs_port_init(struct dentry *parent, struct rtl838x_switch_
 	}
 
 	debugfs_create_u32("id", 0444, port_dir, (u32 *)&priv->ports[port].dp->index);
+	debugfs_create_u32("fdb_learned", 0444, port_dir, &priv->ports[port].fdb_learned);
 
 	port_ctrl_regset = devm_kzalloc(priv->dev, sizeof(*port_ctrl_regset), GFP_KERNEL);
 	if (!port_ctrl_regset)
@@ -277,6 +298,7 @@ static int rtl838x_dbgfs_port_init(struct dentry *parent, struct rtl838x_switch_
 	debugfs_create_file("age_out", 0600, port_dir, &priv->ports[port], &age_out_fops);
 	debugfs_create_file("port_egress_rate", 0600, port_dir, &priv->ports[port],
 			    &port_egress_fops);
+	debugfs_create_file("mib", 0400, port_dir, &priv->ports[port], &mib_fops);
 	return 0;
 }
 
@@ -70,6 +70,190 @@ static void rtl83xx_write_hash(int idx, u32 *r)
 	do { }  while (sw_r32(RTL838X_TBL_ACCESS_L2_CTRL) & BIT(16));
 }
 
+static struct rtl83xx_fdb_entry *rtl83xx_fdb_shadow_find(struct rtl838x_switch_priv *priv,
+							 u64 key)
+{
+	struct rtl83xx_fdb_entry *f;
+
+	hash_for_each_possible(priv->fdb_shadow, f, node, key)
+		if (f->key == key)
+			return f;
+
+	return NULL;
+}
+
+static void rtl83xx_fdb_shadow_del(struct rtl838x_switch_priv *priv,
+				   struct rtl83xx_fdb_entry *f)
+{
+	if (!f->is_static && priv->ports[f->port].fdb_learned)
+		priv->ports[f->port].fdb_learned--;
+	hash_del(&f->node);
+	kmem_cache_free(priv->fdb_cache, f);
+}
+
+/* Record where an entry lives in the L2 table. Must be called with reg_mutex held */
+static void rtl83xx_fdb_shadow_add(struct rtl838x_switch_priv *priv, u64 key,
+				   u32 idx, bool cam, u8 port, bool is_static)
+{
+	struct rtl83xx_fdb_entry *f = rtl83xx_fdb_shadow_find(priv, key);
+
+	if (port >= ARRAY_SIZE(priv->ports))
+		return;
+
+	if (f) {
+		if (!f->is_static && priv->ports[f->port].fdb_learned)
+			priv->ports[f->port].fdb_learned--;
+	} else {
+		f = kmem_cache_zalloc(priv->fdb_cache, GFP_KERNEL);
+		if (!f)
+			return;
+		f->key = key;
+		hash_add(priv->fdb_shadow, &f->node, key);
+	}
+
+	f->stale = false;
+	f->idx = idx;
+	f->cam = cam;
+	f->port = port;
+	f->is_static = is_static;
+	if (!is_static)
+		priv->ports[port].fdb_learned++;
+}
+
+static void rtl83xx_fdb_shadow_flush(struct rtl838x_switch_priv *priv, int port)
+{
+	struct rtl83xx_fdb_entry *f;
+	struct hlist_node *tmp;
+	int bkt;
+
+	hash_for_each_safe(priv->fdb_shadow, bkt, tmp, f, node) {
+		if (port >= 0 && (f->port != port || f->is_static))
+			continue;
+		rtl83xx_fdb_shadow_del(priv, f);
+	}
+}
+
+/*
+ * Entries still present in the table are updated in place, so that a sync
+ * only allocates for addresses learned since the last one
+ */
+static void __rtl83xx_fdb_shadow_sync(struct rtl838x_switch_priv *priv)
+{
+	struct rtl83xx_fdb_entry *f;
+	struct rtl838x_l2_entry e;
+	struct hlist_node *tmp;
+	u64 key;
+	int i, bkt;
+
+	hash_for_each(priv->fdb_shadow, bkt, f, node)
+		f->stale = true;
+
+	for (i = 0; i < priv->fib_entries; i++) {
+		priv->r->read_l2_entry_using_hash(i >> 2, i & 0x3, &e);
+		if (!e.valid)
+			continue;
+		key = ether_addr_to_u64(e.mac) << 12 | e.vid;
+		rtl83xx_fdb_shadow_add(priv, key, i, false, e.port, e.is_static);
+	}
+
+	for (i = 0; i < 64; i++) {
+		priv->r->read_cam(i, &e);
+		if (!e.valid)
+			continue;
+		key = ether_addr_to_u64(e.mac) << 12 | e.vid;
+		rtl83xx_fdb_shadow_add(priv, key, i, true, e.port, e.is_static);
+	}
+
+	hash_for_each_safe(priv->fdb_shadow, bkt, tmp, f, node) {
+		if (f->stale)
+			rtl83xx_fdb_shadow_del(priv, f);
+	}
+
+	priv->fdb_synced = jiffies;
+	WRITE_ONCE(priv->fdb_stale, false);
+}
+
+/* Rebuild the FDB shadow from a full walk of the L2 table */
+void rtl83xx_fdb_shadow_sync(struct rtl838x_switch_priv *priv)
+{
+	mutex_lock(&priv->reg_mutex);
+	__rtl83xx_fdb_shadow_sync(priv);
+	mutex_unlock(&priv->reg_mutex);
+}
+
+/* The slot of a dynamic entry is reused once it ages out, check that the
+ * cached slot still holds the entry before acting on it
+ */
+static bool rtl83xx_fdb_shadow_valid(struct rtl838x_switch_priv *priv,
+				     struct rtl83xx_fdb_entry *f)
+{
+	struct rtl838x_l2_entry e;
+	u64 entry;
+
+	if (f->cam)
+		entry = priv->r->read_cam(f->idx, &e);
+	else
+		entry = priv->r->read_l2_entry_using_hash(f->idx >> 2, f->idx & 0x3, &e);
+
+	return e.valid && (entry & 0x0fffffffffffffffULL) == f->key;
+}
+
+/* Locate an entry in the hash buckets or the CAM, returns the index or -1 */
+static int rtl83xx_fdb_lookup(struct rtl838x_switch_priv *priv, u64 mac, u16 vid,
+			      struct rtl838x_l2_entry *e, bool *cam)
+{
+	u32 key = rtl83xx_hash_key(priv, mac, vid);
+	u64 entry;
+	int i;
+
+	*cam = false;
+	for (i = 0; i < 4; i++) {
+		entry = priv->r->read_l2_entry_using_hash(key, i, e);
+		if (!e->valid)
+			continue;
+		if ((entry & 0x0fffffffffffffffULL) == ((mac << 12) | vid))
+			return (key << 2) | i;
+	}
+
+	*cam = true;
+	for (i = 0; i < 64; i++) {
+		entry = priv->r->read_cam(i, e);
+		if (!e->valid)
+			continue;
+		if ((entry & 0x0fffffffffffffffULL) == ((mac << 12) | vid))
+			return i;
+	}
+
+	return -1;
+}
+
+/* Apply an L2 learning or aging notification to the FDB shadow */
+void rtl83xx_fdb_shadow_event(struct rtl838x_switch_priv *priv, u64 mac, u16 vid, bool add)
+{
+	struct rtl83xx_fdb_entry *f;
+	struct rtl838x_l2_entry e;
+	bool cam;
+	int idx;
+
+	mutex_lock(&priv->reg_mutex);
+
+	f = rtl83xx_fdb_shadow_find(priv, mac << 12 | vid);
+	if (!add) {
+		if (f)
+			rtl83xx_fdb_shadow_del(priv, f);
+		goto out;
+	}
+
+	/* The notification does not carry the table slot, look it up once */
+	idx = rtl83xx_fdb_lookup(priv, mac, vid, &e, &cam);
+	if (idx >= 0)
+		rtl83xx_fdb_shadow_add(priv, mac << 12 | vid, idx, cam, e.port, e.is_static);
+	else if (f)
+		rtl83xx_fdb_shadow_del(priv, f);
+out:
+	mutex_unlock(&priv->reg_mutex);
+}
+
 static void rtl83xx_enable_phy_polling(struct rtl838x_switch_priv *priv)
 {
 	int i;
@@ -142,6 +326,126 @@ const struct rtl83xx_mib_desc rtl83xx_mib[] = {
 };
 
 
+static u64 rtl83xx_mib_read(struct rtl838x_switch_priv *priv, int port,
+			    const struct rtl83xx_mib_desc *mib)
+{
+	int reg = priv->r->stat_port_std_mib + (port << 8) - mib->offset;
+	u32 h, l, h2;
+
+	if (mib->size != 2)
+		return sw_r32(reg + 252);
+
+	/* The halves are not latched, retry if the low word carried over */
+	h = sw_r32(reg + 248);
+	l = sw_r32(reg + 252);
+	h2 = sw_r32(reg + 248);
+	if (h != h2)
+		l = sw_r32(reg + 252);
+
+	return (u64)h2 << 32 | l;
+}
+
+/* Fold the hardware counters of a port into the 64-bit accumulators,
+ * must be called with mib_lock held
+ */
+static void rtl83xx_mib_update(struct rtl838x_switch_priv *priv, int port)
+{
+	struct rtl83xx_mib_counter *c = &priv->mib[port * ARRAY_SIZE(rtl83xx_mib)];
+	struct rtl838x_port *p = &priv->ports[port];
+	int i;
+	u64 v;
+
+	for (i = 0; i < ARRAY_SIZE(rtl83xx_mib); i++) {
+		v = rtl83xx_mib_read(priv, port, &rtl83xx_mib[i]);
+
+		if (rtl83xx_mib[i].size == 2) {
+			c[i].acc = v;
+		} else if (!p->mib_primed) {
+			c[i].acc = v;
+			c[i].last = v;
+		} else {
+			/* Unsigned arithmetic takes care of a wrap */
+			c[i].acc += (u32)v - c[i].last;
+			c[i].last = v;
+		}
+	}
+	p->mib_primed = true;
+	p->mib_stamp = jiffies;
+}
+
+static bool rtl83xx_mib_port_valid(struct rtl838x_switch_priv *priv, int port)
+{
+	return priv->ports[port].phy || port == priv->cpu_port;
+}
+
+static void rtl83xx_mib_work(struct work_struct *work)
+{
+	struct rtl838x_switch_priv *priv =
+		container_of(work, struct rtl838x_switch_priv, mib_work.work);
+	int i;
+
+	for (i = 0; i < priv->ds->num_ports; i++) {
+		if (!rtl83xx_mib_port_valid(priv, i))
+			continue;
+		mutex_lock(&priv->mib_lock);
+		rtl83xx_mib_update(priv, i);
+		mutex_unlock(&priv->mib_lock);
+	}
+
+	schedule_delayed_work(&priv->mib_work, RTL83XX_MIB_POLL_INTERVAL);
+}
+
+static void rtl83xx_mib_init(struct rtl838x_switch_priv *priv)
+{
+	if (!priv->r->stat_port_std_mib)
+		return;
+
+	priv->mib = devm_kcalloc(priv->dev, priv->ds->num_ports * ARRAY_SIZE(rtl83xx_mib),
+				 sizeof(*priv->mib), GFP_KERNEL);
+	if (!priv->mib)
+		return;
+
+	mutex_init(&priv->mib_lock);
+	INIT_DELAYED_WORK(&priv->mib_work, rtl83xx_mib_work);
+	schedule_delayed_work(&priv->mib_work, 0);
+}
+
+/* Copy the accumulated counters of a port, refreshing them first if the
+ * last poll is older than a second
+ */
+static void rtl83xx_mib_get(struct rtl838x_switch_priv *priv, int port, u64 *data)
+{
+	struct rtl83xx_mib_counter *c;
+	int i;
+
+	if (!priv->mib || !rtl83xx_mib_port_valid(priv, port)) {
+		memset(data, 0, ARRAY_SIZE(rtl83xx_mib) * sizeof(*data));
+		return;
+	}
+
+	c = &priv->mib[port * ARRAY_SIZE(rtl83xx_mib)];
+	mutex_lock(&priv->mib_lock);
+	if (!priv->ports[port].mib_primed ||
+	    time_after(jiffies, priv->ports[port].mib_stamp + HZ))
+		rtl83xx_mib_update(priv, port);
+	for (i = 0; i < ARRAY_SIZE(rtl83xx_mib); i++)
+		data[i] = c[i].acc;
+	mutex_unlock(&priv->mib_lock);
+}
+
+int rtl83xx_mib_show(struct seq_file *m, struct rtl838x_switch_priv *priv, int port)
+{
+	u64 data[ARRAY_SIZE(rtl83xx_mib)];
+	int i;
+
+	rtl83xx_mib_get(priv, port, data);
+	for (i = 0; i < ARRAY_SIZE(rtl83xx_mib); i++)
+		seq_printf(m, "%s %llu\n", rtl83xx_mib[i].name, data[i]);
+
+	return 0;
+}
+
+
 /* DSA callbacks */
 
 
@@ -187,6 +491,7 @@ static int rtl83xx_setup(struct dsa_switch *ds)
 		rtl839x_print_matrix();
 
 	rtl83xx_init_stats(priv);
+	rtl83xx_mib_init(priv);
 
 	ds->configure_vlan_while_not_filtering = true;
 
@@ -227,6 +532,7 @@ static int rtl930x_setup(struct dsa_switch *ds)
 	rtl930x_print_matrix();
 
 	// TODO: Initialize statistics
+	rtl83xx_mib_init(priv);
 
 	ds->configure_vlan_while_not_filtering = true;
 
@@ -499,20 +805,7 @@ static void rtl83xx_get_strings(struct dsa_switch *ds,
 static void rtl83xx_get_ethtool_stats(struct dsa_switch *ds, int port,
 				      uint64_t *data)
 {
-	struct rtl838x_switch_priv *priv = ds->priv;
-	const struct rtl83xx_mib_desc *mib;
-	int i;
-	u64 h;
-
-	for (i = 0; i < ARRAY_SIZE(rtl83xx_mib); i++) {
-		mib = &rtl83xx_mib[i];
-
-		data[i] = sw_r32(priv->r->stat_port_std_mib + (port << 8) + 252 - mib->offset);
-		if (mib->size == 2) {
-			h = sw_r32(priv->r->stat_port_std_mib + (port << 8) + 248 - mib->offset);
-			data[i] |= h << 32;
-		}
-	}
+	rtl83xx_mib_get(ds->priv, port, data);
 }
 
 static int rtl83xx_get_sset_count(struct dsa_switch *ds, int port, int sset)
@@ -807,6 +1100,8 @@ void rtl83xx_fast_age(struct dsa_switch *ds, int port)
 
 	do { } while (sw_r32(priv->r->l2_tbl_flush_ctrl) & BIT(26 + s));
 
+	rtl83xx_fdb_shadow_flush(priv, port);
+
 	mutex_unlock(&priv->reg_mutex);
 }
 
@@ -822,6 +1117,8 @@ void rtl930x_fast_age(struct dsa_switch *ds, int port)
 
 	do { } while (sw_r32(priv->r->l2_tbl_flush_ctrl) & BIT(30));
 
+	rtl83xx_fdb_shadow_flush(priv, port);
+
 	mutex_unlock(&priv->reg_mutex);
 }
 
@@ -999,12 +1296,31 @@ static int rtl83xx_port_fdb_add(struct dsa_switch *ds, int port,
 	struct rtl838x_switch_priv *priv = ds->priv;
 	u64 mac = ether_addr_to_u64(addr);
 	u32 key = rtl83xx_hash_key(priv, mac, vid);
+	struct rtl83xx_fdb_entry *f;
 	struct rtl838x_l2_entry e;
 	u32 r[3];
 	u64 entry;
 	int idx = -1, err = 0, i;
+	bool cam = false;
+
+	r[0] = 3 << 17 | port << 12; // Aging and  port
+	r[0] |= vid;
+	r[1] = mac >> 16;
+	r[2] = (mac & 0xffff) << 12; /* rvid = 0 */
 
 	mutex_lock(&priv->reg_mutex);
+
+	/* Known entry: rewrite it in place */
+	f = rtl83xx_fdb_shadow_find(priv, mac << 12 | vid);
+	if (f) {
+		if (rtl83xx_fdb_shadow_valid(priv, f)) {
+			idx = f->idx;
+			cam = f->cam;
+			goto write;
+		}
+		rtl83xx_fdb_shadow_del(priv, f);
+	}
+
 	for (i = 0; i < 4; i++) {
 		entry = priv->r->read_l2_entry_using_hash(key, i, &e);
 		if (!e.valid) {
@@ -1016,16 +1332,11 @@ static int rtl83xx_port_fdb_add(struct dsa_switch *ds, int port,
 			break;
 		}
 	}
-	if (idx >= 0) {
-		r[0] = 3 << 17 | port << 12; // Aging and  port
-		r[0] |= vid;
-		r[1] = mac >> 16;
-		r[2] = (mac & 0xffff) << 12; /* rvid = 0 */
-		rtl83xx_write_hash(idx, r);
-		goto out;
-	}
+	if (idx >= 0)
+		goto write;
 
 	/* Hash buckets full, try CAM */
+	cam = true;
 	for (i = 0; i < 64; i++) {
 		entry = priv->r->read_cam(i, &e);
 		if (!e.valid) {
@@ -1038,15 +1349,17 @@ static int rtl83xx_port_fdb_add(struct dsa_switch *ds, int port,
 			break;
 		}
 	}
-	if (idx >= 0) {
-		r[0] = 3 << 17 | port << 12; // Aging
-		r[0] |= vid;
-		r[1] = mac >> 16;
-		r[2] = (mac & 0xffff) << 12; /* rvid = 0 */
-		rtl83xx_write_cam(idx, r);
+	if (idx < 0) {
+		err = -ENOTSUPP;
 		goto out;
 	}
-	err = -ENOTSUPP;
+
+write:
+	if (cam)
+		rtl83xx_write_cam(idx, r);
+	else
+		rtl83xx_write_hash(idx, r);
+	rtl83xx_fdb_shadow_add(priv, mac << 12 | vid, idx, cam, port, false);
 out:
 	mutex_unlock(&priv->reg_mutex);
 	return err;
@@ -1057,44 +1370,38 @@ static int rtl83xx_port_fdb_del(struct dsa_switch *ds, int port,
 {
 	struct rtl838x_switch_priv *priv = ds->priv;
 	u64 mac = ether_addr_to_u64(addr);
-	u32 key = rtl83xx_hash_key(priv, mac, vid);
+	struct rtl83xx_fdb_entry *f;
 	struct rtl838x_l2_entry e;
-	u32 r[3];
-	u64 entry;
-	int idx = -1, err = 0, i;
+	u32 r[3] = { 0, 0, 0 };
+	int idx, err = 0;
+	bool cam;
 
-	pr_debug("In %s, mac %llx, vid: %d, key: %x08x\n", __func__, mac, vid, key);
+	pr_debug("In %s, mac %llx, vid: %d\n", __func__, mac, vid);
 	mutex_lock(&priv->reg_mutex);
-	for (i = 0; i < 4; i++) {
-		entry = priv->r->read_l2_entry_using_hash(key, i, &e);
-		if (!e.valid)
-			continue;
-		if ((entry & 0x0fffffffffffffffULL) == ((mac << 12) | vid)) {
-			idx = (key << 2) | i;
-			break;
-		}
+
+	f = rtl83xx_fdb_shadow_find(priv, mac << 12 | vid);
+	if (f && rtl83xx_fdb_shadow_valid(priv, f)) {
+		idx = f->idx;
+		cam = f->cam;
+		rtl83xx_fdb_shadow_del(priv, f);
+	} else {
+		/* Not mirrored yet, e.g. learned since the last sync, or moved
+		 * to another slot after aging out
+		 */
+		if (f)
+			rtl83xx_fdb_shadow_del(priv, f);
+		idx = rtl83xx_fdb_lookup(priv, mac, vid, &e, &cam);
 	}
 
-	if (idx >= 0) {
-		r[0] = r[1] = r[2] = 0;
-		rtl83xx_write_hash(idx, r);
+	if (idx < 0) {
+		err = -ENOENT;
 		goto out;
 	}
 
-	/* Check CAM for spillover from hash buckets */
-	for (i = 0; i < 64; i++) {
-		entry = priv->r->read_cam(i, &e);
-		if ((entry & 0x0fffffffffffffffULL) == ((mac << 12) | vid)) {
-			idx = i;
-			break;
-		}
-	}
-	if (idx >= 0) {
-		r[0] = r[1] = r[2] = 0;
+	if (cam)
 		rtl83xx_write_cam(idx, r);
-		goto out;
-	}
-	err = -ENOENT;
+	else
+		rtl83xx_write_hash(idx, r);
 out:
 	mutex_unlock(&priv->reg_mutex);
 	return err;
@@ -1103,39 +1410,27 @@ out:
 static int rtl83xx_port_fdb_dump(struct dsa_switch *ds, int port,
 				 dsa_fdb_dump_cb_t *cb, void *data)
 {
-	struct rtl838x_l2_entry e;
 	struct rtl838x_switch_priv *priv = ds->priv;
-	int i;
-	u32 fid;
-	u32 pkey;
-	u64 mac;
+	struct rtl83xx_fdb_entry *f;
+	unsigned char addr[ETH_ALEN];
+	int bkt;
 
 	mutex_lock(&priv->reg_mutex);
 
-	for (i = 0; i < priv->fib_entries; i++) {
-		priv->r->read_l2_entry_using_hash(i >> 2, i & 0x3, &e);
-
-		if (!e.valid)
-			continue;
-
-		if (e.port == port) {
-			fid = (i & 0x3ff) | (e.rvid & ~0x3ff);
-			mac = ether_addr_to_u64(&e.mac[0]);
-			pkey = rtl838x_hash(priv, mac << 12 | fid);
-			fid = (pkey & 0x3ff) | (fid & ~0x3ff);
-			pr_debug("-> mac %016llx, fid: %d\n", mac, fid);
-			cb(e.mac, e.vid, e.is_static, data);
-		}
-	}
-
-	for (i = 0; i < 64; i++) {
-		priv->r->read_cam(i, &e);
+	/* Without L2 notifications the shadow only tracks our own changes,
+	 * and notifications can get lost in the ethernet driver's ring or
+	 * never be sent for aging. Refresh it from the table at most once per
+	 * second so that a dump across all ports costs a single walk
+	 */
+	if (READ_ONCE(priv->fdb_stale) ||
+	    time_after(jiffies, priv->fdb_synced + HZ))
+		__rtl83xx_fdb_shadow_sync(priv);
 
-		if (!e.valid)
+	hash_for_each(priv->fdb_shadow, bkt, f, node) {
+		if (f->port != port)
 			continue;
-
-		if (e.port == port)
-			cb(e.mac, e.vid, e.is_static, data);
+		u64_to_ether_addr(f->key >> 12, addr);
+		cb(addr, f->key & 0xfff, f->is_static, data);
 	}
 
 	mutex_unlock(&priv->reg_mutex);
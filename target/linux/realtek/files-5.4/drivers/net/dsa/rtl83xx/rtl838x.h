@@ -3,6 +3,7 @@
 #ifndef _RTL838X_H
 #define _RTL838X_H
 
+#include <linux/hashtable.h>
 #include <net/dsa.h>
 
 /*
@@ -325,6 +326,15 @@
 #define MAX_LAGS 16
 #define MAX_PRIOS 8
 
+#define RTL83XX_FDB_HASH_BITS 10
+
+#define RTL83XX_MIB_POLL_INTERVAL	(5 * HZ)
+
+struct rtl83xx_mib_counter {
+	u64 acc;
+	u32 last;	/* Last raw value of a 32-bit counter */
+};
+
 enum phy_type {
 	PHY_NONE = 0,
 	PHY_RTL838X_SDS = 1,
@@ -344,6 +354,9 @@ struct rtl838x_port {
 	bool is2G5;
 	u8 sds_num;
 	const struct dsa_port *dp;
+	u32 fdb_learned;
+	bool mib_primed;
+	unsigned long mib_stamp;
 };
 
 struct rtl838x_vlan_info {
@@ -383,6 +396,17 @@ struct rtl838x_l2_entry {
 	u16 mc_portmask_index;
 };
 
+/* Software copy of an L2 table entry, keyed by mac << 12 | vid */
+struct rtl83xx_fdb_entry {
+	struct hlist_node node;
+	u64 key;
+	u32 idx;	/* Hash table index or CAM slot */
+	bool cam;
+	u8 port;
+	bool is_static;
+	bool stale;	/* Not seen yet by the sync in progress */
+};
+
 struct rtl838x_switch_priv;
 
 struct rtl838x_reg {
@@ -465,6 +489,15 @@ struct rtl838x_switch_priv {
 	u64 lags_port_members[MAX_LAGS];
 	struct net_device *lag_devs[MAX_LAGS];
 	struct notifier_block nb;
+	struct notifier_block fdb_nb;
+	DECLARE_HASHTABLE(fdb_shadow, RTL83XX_FDB_HASH_BITS);
+	struct kmem_cache *fdb_cache;
+	bool fdb_notify;	/* Shadow is kept current by L2 notifications */
+	bool fdb_stale;
+	unsigned long fdb_synced;
+	struct rtl83xx_mib_counter *mib;	/* num_ports x rtl83xx_mib */
+	struct mutex mib_lock;
+	struct delayed_work mib_work;
 };
 
 void rtl838x_dbgfs_init(struct rtl838x_switch_priv *priv);
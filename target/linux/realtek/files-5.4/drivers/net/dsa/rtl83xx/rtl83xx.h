@@ -3,6 +3,7 @@
 #ifndef _NET_DSA_RTL83XX_H
 #define _NET_DSA_RTL83XX_H
 
+#include <linux/seq_file.h>
 #include <net/dsa.h>
 #include "rtl838x.h"
 
@@ -17,6 +18,14 @@ struct fdb_update_work {
 	u64 macs[];
 };
 
+struct rtl83xx_fdb_event_work {
+	struct work_struct work;
+	struct rtl838x_switch_priv *priv;
+	u64 mac;
+	u16 vid;
+	bool add;
+};
+
 #define MIB_DESC(_size, _offset, _name) {.size = _size, .offset = _offset, .name = _name}
 struct rtl83xx_mib_desc {
 	unsigned int size;
@@ -73,6 +82,11 @@ inline u16 rtl_table_data(struct table_reg *r, int i);
 inline u32 rtl_table_data_r(struct table_reg *r, int i);
 inline void rtl_table_data_w(struct table_reg *r, u32 v, int i);
 
+void rtl83xx_fdb_shadow_sync(struct rtl838x_switch_priv *priv);
+void rtl83xx_fdb_shadow_event(struct rtl838x_switch_priv *priv, u64 mac, u16 vid, bool add);
+
+int rtl83xx_mib_show(struct seq_file *m, struct rtl838x_switch_priv *priv, int port);
+
 void __init rtl83xx_setup_qos(struct rtl838x_switch_priv *priv);
 int read_phy(u32 port, u32 page, u32 reg, u32 *val);
 int write_phy(u32 port, u32 page, u32 reg, u32 val);
@@ -343,7 +343,7 @@ void rtl838x_fdb_sync(struct work_struct *work)
 				: SWITCHDEV_FDB_DEL_TO_BRIDGE;
 		u64_to_ether_addr(uw->macs[i] & 0xffffffffffffULL, addr);
 		info.addr = &addr[0];
-		info.vid = 0;
+		info.vid = (uw->macs[i] >> 48) & 0xfff;
 		info.offloaded = 1;
 		pr_debug("FDB entry %d: %llx, action %d\n", i, uw->macs[0], action);
 		call_switchdev_notifiers(action, uw->ndev, &info.info, NULL);
@@ -373,7 +373,8 @@ static void rtl839x_l2_notification_handler(struct rtl838x_eth_priv *priv)
 			event = &nb->blocks[e].events[i];
 			if (!event->valid)
 				continue;
-			mac = event->mac;
+			/* MAC in bits 0-47, FID/VID in 48-59, add flag in 63 */
+			mac = event->mac | ((u64)event->fidVid << 48);
 			if (event->type)
 				mac |= 1ULL << 63;
 			w->ndev = priv->netdev;